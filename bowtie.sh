@@ -22,12 +22,12 @@ function run_bowtie() {
     fi
     outname="$BOWTIE_TEMP_DIR/$5"
     if [ "$phase" == "phase1" ]; then
-        log "bowtie $bowtie_index_file $QUALS  $params -q $inputs --un ${outname}.unmapped.txt ${outname}.bowtie.txt"
-        try $BOWTIE_PROGRAM $bowtie_index_file $QUALS $params -q $inputs --un "$outname".unmapped.txt "$outname".bowtie.txt >> "$LOG_FILE" 2>&1
+        log "bowtie $bowtie_index_file $QUALS  $params -q $inputs --un ${outname}.unmapped.txt$TEMP_SUFFIX ${outname}.bowtie.txt$TEMP_SUFFIX"
+        try $BOWTIE_PROGRAM $bowtie_index_file $QUALS $params -q $inputs --un "$outname".unmapped.txt$TEMP_SUFFIX "$outname".bowtie.txt$TEMP_SUFFIX >> "$LOG_FILE" 2>&1
         #try $BOWTIE_PROGRAM $bowtie_index_file $QUALS $params -q $inputs --un "$outname".unmapped.txt -S "$outname".bowtie.SAM.txt >> "$LOG_FILE" 2>&1
     elif [ "$phase" == "phase2" ]; then
-        log "bowtie $bowtie_index_file $QUALS  $params -q $inputs $outname.bowtie.txt"
-        try $BOWTIE_PROGRAM $bowtie_index_file $QUALS $params -q $inputs "$outname".bowtie.txt >> "$LOG_FILE" 2>&1
+        log "bowtie $bowtie_index_file $QUALS  $params -q $inputs $outname.bowtie.txt$TEMP_SUFFIX"
+        try $BOWTIE_PROGRAM $bowtie_index_file $QUALS $params -q $inputs "$outname".bowtie.txt$TEMP_SUFFIX >> "$LOG_FILE" 2>&1
     else
         die "Don't know what to do on phase $phase"
     fi
@@ -39,10 +39,13 @@ function run_bowtie() {
 #------MAIN-------
 
 if (( $# < 4 )); then
-yell "usage -- $0 genome phase fileSet maxGoodAlignments"
-yell "      fileSet should be a comma-separated list of fastQ files"
+yell "usage -- $0 genome phase fileSet maxGoodAlignments [sourceFile]"
+yell "      fileSet should be a comma-separated list of fastQ files (may be .gz)"
 yell "              Optionally, a second set of comma-separated files"
 yell "              May be added, separated by a pipe | for paired-end"
+yell "              Or - to read from stdin, in which case sourceFile is the"
+yell "              reads file stdin was made from (srr --stdout), used for"
+yell "              naming the output and guessing the quality encoding"
 exit 1
 fi
 
@@ -60,14 +63,23 @@ if [[ $3 =~ .*\|.* ]]; then # Paired mode
     IFS=$OIFS
     input_params="-1 $pair1 -2 $pair2"
     outname=$(python $BASENAME_SCRIPT "$(echo $pair1 | cut -d, -f1)")
-    QUALS=$(awk 'NR % 4 == 0' $(echo "$pair1" | cut -d, -f1) | head -$(( $QUALITY_TESTS * 4)) | python $ENCODING_GUESSER -b -n $QUALITY_TESTS)
+    QUALS=$(gzip -dcf $(echo "$pair1" | cut -d, -f1) | awk 'NR % 4 == 0' | head -$(( $QUALITY_TESTS * 4)) | python $ENCODING_GUESSER -b -n $QUALITY_TESTS)
+
+elif [ "$3" == "-" ]; then # reads piped from srr, name output as if split to a file
+    if [ -z "$5" ]; then die "reading from stdin needs the file it was made from"; fi
+    input_params="-"
+    outname="$(python $BASENAME_SCRIPT "${5%.gz}").split"
+    QUALS=$(gzip -dcf "$5" | awk 'NR % 4 == 0' | head -$(( $QUALITY_TESTS * 4)) | python $ENCODING_GUESSER -b -n $QUALITY_TESTS)
 
 else
     input_params=$3
     outname=$(python $BASENAME_SCRIPT "$(echo $3 | cut -d, -f1)")
-    QUALS=$(awk 'NR % 4 == 0' $(echo "$3" | cut -d, -f1) | head -$(( $QUALITY_TESTS * 4)) | python $ENCODING_GUESSER -b -n $QUALITY_TESTS)
+    QUALS=$(gzip -dcf $(echo "$3" | cut -d, -f1) | awk 'NR % 4 == 0' | head -$(( $QUALITY_TESTS * 4)) | python $ENCODING_GUESSER -b -n $QUALITY_TESTS)
 fi
 
+#output of name.gz is named as if from name
+outname=${outname%.gz}
+
 #number of threads is now 1/4 of total cores on the system--this doesn't seem
 # to be slower than using 3/4 of total cores
 #bowtie_params="-t --chunkmbs 2048 -p $(( $(grep -c ^processor /proc/cpuinfo) * 1 / 4)) "
@@ -76,6 +88,10 @@ if [ "$2" == "phase1" ]; then
 	bowtie_params+="-n 3 -e 112"
 elif [ "$2" == "phase2" ]; then
 	bowtie_params+="--best -k $4 -m $4 -v 0"
+	if [ -n "$RSF_SPLIT_MIN" ]; then # bowtie splits the reads, name output as if split by srr
+		bowtie_params+=" --rsf-split $RSF_SPLIT_MIN"
+		outname="${outname}.split"
+	fi
 fi
 log "BOWTIE_INDEX_ROOT: $BOWTIE_INDEX_DIR, BOWTIE_INDEXES: $BOWTIE_INDEXES"
 log "bowtying $2 $genome $bowtie_params $input_params"
@@ -11,6 +11,8 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <algorithm>
 #include <iostream>
 #include <getopt.h>
 #include <fstream>
@@ -22,6 +24,7 @@
 #include "ebwt.h"
 #include "reference.h"
 #include "addRange.h"
+#include "../src/rsf_stats.h"
 
 using namespace std;
 using namespace seqan;
@@ -41,6 +44,8 @@ static string chrName = "";
 static string resultFileName = "";
 static string outputFileName = "";
 static string wrapper;
+static long long batchLines = 0;   // results lines given sequences, for $RSF_STATS_FILE
+static long long bytesWritten = 0; // size of the output file, for $RSF_STATS_FILE
 static const char *short_options = "vhnsea:i:j:c:f:o:";
 
 enum {
@@ -396,54 +401,6 @@ void print_ref_sequence_RSR(
 	delete buf;
 }
 
-/**
- * Given output stream, BitPairReference, reference index, name and
- * length, return the reference from start to stop in a string.
- */
-std::string get_ref_sequence_RSR_string(
-	BitPairReference& ref,
-	const string& name,
-	size_t refi,
-	size_t len)
-{
-	int size = 0;
-  size_t start, stop;
-	string returnStr = "";
-  if (startIndex > 0) start = startIndex;
-  else start = 0;
-  
-  if (stopIndex > 0) stop = stopIndex;
-  else stop = len;
-
-	bool newlines = across > 0;
-	int myacross = across > 0 ? across : 60;
-	size_t incr = myacross * 1000;
-	uint32_t *buf = new uint32_t[(incr + 128)/4];
-	//fout << ">" << name << "\n";
-	if (stop > len) stop = len;
-	char cbuf[stop - start + 2];
-	for(size_t i = start; i < stop; i += incr) {
-		size_t amt = min(incr, stop-i);
-		assert_leq(amt, incr);
-		int off = ref.getStretch(buf, refi, i, amt);
-		//uint8_t i*cb = ((uint8_t*)buf) + off;
-		uint8_t *cb = ((uint8_t*)buf) + off;
-		for(size_t j = 0; j < amt; j++) {
-			//if(newlines && j > 0 && (j % myacross) == 0) fout << "\n";
-			assert_range(0, 4, (int)cb[j]);
-			//fout << "ACGTN"[(int)cb[j]];
-			//returnStr.append("ACGTN"[(int)cb[j]]);
-			cbuf[size++] = "ACGTN"[(int)cb[j]];
-		}
-		//fout << "\n";
-	}
-	cbuf[size] = '\0';
-	returnStr = returnStr.append(cbuf);
-
-	delete buf;
-	return returnStr;
-}
-
 /* Takes the string &range and edits it from ABCD--EFGH to ABCD]--[EFGH form.
  * If the form isn't in the correct form to begin with, this function does
  * nothing and returns immediately. */
@@ -508,18 +465,176 @@ void print_batch_line(ostream &fout, vector<string> &tokens, string &splSeq, int
 			*itr = editRange(*itr);
 		}
 		fout << *itr << '\t';
-		fout.flush();
 		tokNo += 1;
 	}
 	// First, output the bracketed sequence
 	string newBrackSeq = lBrack.append("]--[").append(rBrack);
 	fout << newBrackSeq << '\t';
 	// Then, output the junction site region
-	fout << splSeq << endl;
-	fout.flush();
+	fout << splSeq << '\n';
 	return;
 }
 
+/**
+ * One line of the results file in batch mode, and the part of the
+ * reference to get for it: [start, stop) of reference refi.
+ */
+struct BatchRequest {
+	size_t line;  // line number, counting from the header line
+	size_t refi;  // index of the chromosome, numRefs if not in the index
+	size_t start;
+	size_t stop;
+
+	bool operator<(const BatchRequest& o) const {
+		if(refi != o.refi) return refi < o.refi;
+		if(start != o.start) return start < o.start;
+		return line < o.line;
+	}
+};
+
+/**
+ * Given BitPairReference, reference index, and a range, append the
+ * reference from start to stop to seq.  buf is room for incr bases,
+ * used for each piece of the range in turn.
+ */
+void append_ref_range(
+	BitPairReference& ref,
+	size_t refi,
+	size_t start,
+	size_t stop,
+	uint32_t *buf,
+	size_t incr,
+	string& seq)
+{
+	for(size_t i = start; i < stop; i += incr) {
+		size_t amt = min(incr, stop-i);
+		int off = ref.getStretch(buf, refi, i, amt);
+		uint8_t *cb = ((uint8_t*)buf) + off;
+		for(size_t j = 0; j < amt; j++) {
+			assert_range(0, 4, (int)cb[j]);
+			seq.push_back("ACGTN"[(int)cb[j]]);
+		}
+	}
+}
+
+/**
+ * Given BitPairReference and a batch of requests, sort the requests and
+ * put the reference for each one in splSeqs[line].  Ranges are taken in
+ * one pass through each chromosome, and a run of overlapping ranges
+ * (nearby junctions of the same gene) is only decoded once.  A
+ * chromosome that isn't in the index gets all Ns.
+ */
+void get_batch_sequences(
+	BitPairReference& ref,
+	vector<BatchRequest>& requests,
+	vector<string>& splSeqs,
+	uint32_t *stretchBuf,
+	size_t incr)
+{
+	sort(requests.begin(), requests.end());
+
+	string region; // decoded reference for a run of overlapping ranges
+	size_t i = 0;
+	while(i < requests.size()) {
+		size_t refi = requests[i].refi;
+		size_t regionStart = requests[i].start, regionStop = requests[i].stop;
+		size_t j = i+1;
+		while(j < requests.size() && requests[j].refi == refi && requests[j].start <= regionStop) {
+			regionStop = max(regionStop, requests[j].stop);
+			j++;
+		}
+
+		region.clear();
+		if(refi < ref.numNonGapRefs()) {
+			append_ref_range(ref, refi, regionStart, regionStop, stretchBuf, incr, region);
+		} else {
+			region.assign(regionStop - regionStart, 'N');
+		}
+		for(; i < j; i++) {
+			splSeqs[requests[i].line].assign(region, requests[i].start - regionStart,
+			                                 requests[i].stop - requests[i].start);
+		}
+	}
+}
+
+// Most bases of reference to hold for one batch of results lines
+static const size_t BATCH_BASES = 64 * 1024 * 1024;
+
+/**
+ * Batch mode: add the bracketed and spliced sequences to each line of
+ * the results file after the header line.
+ *
+ * Lines are read in batches of up to BATCH_BASES of reference, their
+ * chromosomes looked up in a map of the reference names made once, and
+ * their sequences got by get_batch_sequences.  Each batch is printed in
+ * the original order of its lines.
+ */
+void print_batch_sequences(
+	ifstream& resultFile,
+	ostream& fout,
+	BitPairReference& ref,
+	bool color,
+	const vector<string>& refnames,
+	const TIndexOffU* plen)
+{
+	long wideL = 0, wideR = 0, rangeL = 0, rangeR = 0, spliceLen = 0;
+	string buf, name;
+	vector<vector<string> > lines;
+	vector<long> spliceSeqLen;
+	vector<BatchRequest> requests;
+	vector<string> splSeqs;
+
+	map<string, size_t> refIndex;
+	for(size_t i = 0; i < ref.numNonGapRefs(); i++) {
+		refIndex[refnames[i]] = i;
+	}
+
+	int myacross = across > 0 ? across : 60;
+	size_t incr = myacross * 1000;
+	uint32_t *stretchBuf = new uint32_t[(incr + 128)/4];
+
+	getline(resultFile, buf); 
+	while( !resultFile.eof() ) {
+		size_t batchBases = 0;
+		lines.clear();
+		spliceSeqLen.clear();
+		requests.clear();
+		while( !resultFile.eof() && batchBases < BATCH_BASES ) {
+			lines.push_back(splitString(buf, '\t'));
+			getRefSearchData(lines.back(), name, rangeL, rangeR, wideL, wideR, spliceLen); 
+
+			BatchRequest r;
+			r.line = lines.size()-1;
+			r.start = wideL > 0 ? wideL : 0;
+			map<string, size_t>::iterator it = refIndex.find(name);
+			if(it != refIndex.end()) {
+				r.refi = it->second;
+				size_t len = plen[r.refi] + (color ? 1 : 0);
+				r.stop = wideR > 0 ? wideR : len;
+				if(r.stop > len) r.stop = len;
+			} else {
+				r.refi = ref.numNonGapRefs();
+				r.stop = wideR > 0 ? wideR : 0;
+			}
+			if(r.stop < r.start) r.stop = r.start;
+			requests.push_back(r);
+			spliceSeqLen.push_back(rangeR-rangeL);
+			batchBases += r.stop - r.start;
+			getline(resultFile, buf); 
+		}
+
+		splSeqs.resize(lines.size());
+		get_batch_sequences(ref, requests, splSeqs, stretchBuf, incr);
+
+		for(size_t k = 0; k < lines.size(); k++) {
+			//splSeqs[k] contains the spliced sequence + BOUNDARY_LEN extra nucl. on each side
+			print_batch_line(fout, lines[k], splSeqs[k], spliceSeqLen[k], BOUNDARY_LEN);
+			batchLines++;
+		}
+	}
+	delete[] stretchBuf;
+}
+
 /**
  * Create a BitPairReference encapsulating the reference portion of the
  * index at the given basename.  Iterate through the reference
@@ -554,30 +669,7 @@ void print_ref_sequences(
 
 #ifdef ACCOUNT_FOR_ALL_GAP_REFS
 	if( batchMode ) {
-		long wideL, wideR, rangeL, rangeR, spliceLen;
-		string buf, bracketL, bracketR, splSeq;
-		vector<string> tokens;
-
-		getline(resultFile, buf); 
-		while( !resultFile.eof() ) {
-			tokens = splitString(buf, '\t');
-			getRefSearchData(tokens, chrName, rangeL, rangeR, wideL, wideR, spliceLen); 
-			startIndex = wideL;
-			stopIndex = wideR;
-
-			for(size_t i = 0; i < ref.numNonGapRefs(); i++) {
-				if( chrName == refnames[i] ) {
-					splSeq = get_ref_sequence_RSR_string(
-						ref,
-						chrName,
-						i,
-						plen[i] + (color ? 1 : 0));
-				}
-			}
-			//splSeq contains the spliced sequence + 15 extra nucl. on each side
-			print_batch_line(fout, tokens, splSeq, rangeR-rangeL, BOUNDARY_LEN );  
-			getline(resultFile, buf); 
-		}
+		print_batch_sequences(resultFile, fout, ref, color, refnames, plen);
 	}
 	else {	//not batch mode
 		for(size_t i = 0; i < ref.numRefs(); i++) {
@@ -601,30 +693,7 @@ void print_ref_sequences(
 #else
 	assert_eq(refnames.size(), ref.numNonGapRefs());
 	if( batchMode ) {
-		long wideL, wideR, rangeL, rangeR, spliceLen;
-		string buf, bracketL, bracketR, splSeq;
-		vector<string> tokens;
-
-		getline(resultFile, buf); 
-		while( !resultFile.eof() ) {
-			tokens = splitString(buf, '\t');
-			getRefSearchData(tokens, chrName, rangeL, rangeR, wideL, wideR, spliceLen); 
-			startIndex = wideL;
-			stopIndex = wideR;
-
-			for(size_t i = 0; i < ref.numNonGapRefs(); i++) {
-				if( chrName == refnames[i] ) {
-					splSeq = get_ref_sequence_RSR_string(
-						ref,
-						chrName,
-						i,
-						plen[i] + (color ? 1 : 0));
-				}
-			}
-			//splSeq contains the spliced sequence + BOUNDARY_LEN  extra nucl. on each side
-			print_batch_line(fout, tokens, splSeq, rangeR-rangeL, BOUNDARY_LEN );  
-			getline(resultFile, buf); 
-		}
+		print_batch_sequences(resultFile, fout, ref, color, refnames, plen);
 	}
 	else { //not batch mode 
 		for(size_t i = 0; i < ref.numNonGapRefs(); i++) {
@@ -879,6 +948,9 @@ static void driver(
 				refnames,
 				ebwt.plen(),
 				adjustedEbwtFileBase);
+			if(writeFile.is_open()) {
+				bytesWritten = writeFile.tellp();
+			}
 		}
 		// Evict any loaded indexes from memory
 		if(ebwt.isInMemory()) {
@@ -938,7 +1010,15 @@ int main(int argc, char **argv) {
 			cout << "Assertions: enabled" << endl;
 #endif
 		}
+		struct rsf_stats stats;
+		rsf_stats_begin(&stats, "bowtie-inspect-RSR", batchMode ? "splice_sequences" : "inspect");
+		if(!resultFileName.empty()) {
+			stats.bytesIn = rsf_stats_file_size(resultFileName.c_str());
+		}
 		driver(ebwtFile, query);
+		stats.bytesOut = bytesWritten;
+		stats.records = batchLines;
+		rsf_stats_end(&stats);
 		return 0;
 	} catch(std::exception& e) {
 		cerr << "Command: ";
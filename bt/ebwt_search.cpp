@@ -125,6 +125,7 @@ static size_t fastaContLen;
 static size_t fastaContFreq;
 static bool hadoopOut; // print Hadoop status and summary messages
 static bool fuzzy;
+static int rsfSplit; // >0 -> align split pieces of each read, this is the min piece length
 static bool fullRef;
 static bool samNoQnameTrunc; // don't truncate QNAME field at first whitespace
 static bool samNoHead; // don't print any header lines in SAM output
@@ -258,6 +259,7 @@ static void resetOptions() {
 	wrapper.clear();
 	gAllowMateContainment	= false; // true -> alignments where one mate lies inside the other are valid
 	gReportColorPrimer		= false; // true -> print flag with trimmed color primer and downstream color
+	rsfSplit				= 0;     // align reads as given, not split into pieces
 }
 
 // mating constraints
@@ -344,7 +346,8 @@ enum {
 	ARG_QUALS2,
 	ARG_ALLOW_CONTAIN,
 	ARG_COLOR_PRIMER,
-	ARG_WRAPPER
+	ARG_WRAPPER,
+	ARG_RSF_SPLIT
 };
 
 static struct option long_options[] = {
@@ -454,6 +457,7 @@ static struct option long_options[] = {
 	{(char*)"allow-contain",no_argument,       0,            ARG_ALLOW_CONTAIN},
 	{(char*)"col-primer",   no_argument,       0,            ARG_COLOR_PRIMER},
 	{(char*)"wrapper",      required_argument, 0,            ARG_WRAPPER},
+	{(char*)"rsf-split",    required_argument, 0,            ARG_RSF_SPLIT},
 	{(char*)0, 0, 0, 0} // terminator
 };
 
@@ -498,7 +502,9 @@ static void printUsage(ostream& out) {
 		<< "  --phred64-quals    input quals are Phred+64 (same as --solexa1.3-quals)" << endl
 		<< "  --solexa-quals     input quals are from GA Pipeline ver. < 1.3" << endl
 		<< "  --solexa1.3-quals  input quals are from GA Pipeline ver. >= 1.3" << endl
-		<< "  --integer-quals    qualities are given as space-separated integers (not ASCII)" << endl;
+		<< "  --integer-quals    qualities are given as space-separated integers (not ASCII)" << endl
+		<< "  --rsf-split <int>  align split pieces of each read, as made by srr (Read-Split-Fly)," << endl
+		<< "                     with pieces at least <int> long" << endl;
 		if(wrapper == "basic-0") {
 		out << "  --large-index      force usage of a 'large' index, even if a small one is present" << endl;
 		}
@@ -653,6 +659,9 @@ static void parseOptions(int argc, const char **argv) {
 			short_options, long_options, &option_index);
 		switch (next_option) {
 			case ARG_WRAPPER: wrapper = optarg; break;
+			case ARG_RSF_SPLIT:
+				rsfSplit = parseInt(1, "--rsf-split arg must be at least 1");
+				break;
 			case '1': tokenize(optarg, ",", mates1); break;
 			case '2': tokenize(optarg, ",", mates2); break;
 			case ARG_ONETWO: tokenize(optarg, ",", mates12); format = TAB_MATE; break;
@@ -887,6 +896,10 @@ static void parseOptions(int argc, const char **argv) {
 		// Much faster than normal 3-mismatch mode
 		stateful = true;
 	}
+	if(rsfSplit > 0 && (paired || color)) {
+		cerr << "Error: --rsf-split works only with unpaired reads, not -1/-2/--12 or -C" << endl;
+		throw 1;
+	}
 	if(mates1.size() != mates2.size()) {
 		cerr << "Error: " << mates1.size() << " mate files/sequences were specified with -1, but " << mates2.size() << endl
 		     << "mate files/sequences were specified with -2.  The same number of mate files/" << endl
@@ -2537,6 +2550,11 @@ static void driver(const char * type,
 		if(quals->empty()) quals = NULL;
 		patsrc = patsrcFromStrings(format, *qs, quals);
 		assert(patsrc != NULL);
+		if(rsfSplit > 0) {
+			// Align the split pieces of the reads instead of the reads
+			patsrc = new SplitReadPatternSource(patsrc, rsfSplit, seed,
+			                                    false, NULL, verbose);
+		}
 		patsrcs_a.push_back(patsrc);
 		patsrcs_b.push_back(NULL);
 		if(!fileParallel) {
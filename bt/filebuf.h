@@ -13,11 +13,12 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdexcept>
+#include <zlib.h>
 #include "assert_helpers.h"
 
 /**
- * Simple wrapper for a FILE*, istream or ifstream that reads it in
- * chunks (with fread) and keeps those chunks in a buffer.  It also
+ * Simple wrapper for a FILE*, gzFile, istream or ifstream that reads it
+ * in chunks (with fread/gzread) and keeps those chunks in a buffer.  It also
  * services calls to get(), peek() and gets() from the buffer, reading
  * in additional chunks when necessary.
  */
@@ -33,6 +34,12 @@ public:
 		assert(_in != NULL);
 	}
 
+	FileBuf(gzFile in) {
+		init();
+		_zIn = in;
+		assert(_zIn != NULL);
+	}
+
 	FileBuf(std::ifstream *inf) {
 		init();
 		_inf = inf;
@@ -46,7 +53,7 @@ public:
 	}
 
 	bool isOpen() {
-		return _in != NULL || _inf != NULL || _ins != NULL;
+		return _in != NULL || _zIn != NULL || _inf != NULL || _ins != NULL;
 	}
 
 	/**
@@ -55,6 +62,8 @@ public:
 	void close() {
 		if(_in != NULL && _in != stdin) {
 			fclose(_in);
+		} else if(_zIn != NULL) {
+			gzclose(_zIn);
 		} else if(_inf != NULL) {
 			_inf->close();
 		} else {
@@ -66,7 +75,7 @@ public:
 	 * Get the next character of input and advance.
 	 */
 	int get() {
-		assert(_in != NULL || _inf != NULL || _ins != NULL);
+		assert(_in != NULL || _zIn != NULL || _inf != NULL || _ins != NULL);
 		int c = peek();
 		if(c != -1) {
 			_cur++;
@@ -87,6 +96,20 @@ public:
 	 */
 	void newFile(FILE *in) {
 		_in = in;
+		_zIn = NULL;
+		_inf = NULL;
+		_ins = NULL;
+		_cur = BUF_SZ;
+		_buf_sz = BUF_SZ;
+		_done = false;
+	}
+
+	/**
+	 * Initialize the buffer with a new gzip-compressed file.
+	 */
+	void newFile(gzFile in) {
+		_in = NULL;
+		_zIn = in;
 		_inf = NULL;
 		_ins = NULL;
 		_cur = BUF_SZ;
@@ -99,6 +122,7 @@ public:
 	 */
 	void newFile(std::ifstream *__inf) {
 		_in = NULL;
+		_zIn = NULL;
 		_inf = __inf;
 		_ins = NULL;
 		_cur = BUF_SZ;
@@ -111,6 +135,7 @@ public:
 	 */
 	void newFile(std::istream *__ins) {
 		_in = NULL;
+		_zIn = NULL;
 		_inf = NULL;
 		_ins = __ins;
 		_cur = BUF_SZ;
@@ -129,6 +154,8 @@ public:
 		} else if(_ins != NULL) {
 			_ins->clear();
 			_ins->seekg(0, std::ios::beg);
+		} else if(_zIn != NULL) {
+			gzrewind(_zIn);
 		} else {
 			rewind(_in);
 		}
@@ -143,7 +170,7 @@ public:
 	 * Occasionally we'll need to read in a new buffer's worth of data.
 	 */
 	int peek() {
-		assert(_in != NULL || _inf != NULL || _ins != NULL);
+		assert(_in != NULL || _zIn != NULL || _inf != NULL || _ins != NULL);
 		assert_leq(_cur, _buf_sz);
 		if(_cur == _buf_sz) {
 			if(_done) {
@@ -159,6 +186,17 @@ public:
 				} else if(_ins != NULL) {
 					_ins->read((char*)_buf, BUF_SZ);
 					_buf_sz = _ins->gcount();
+				} else if(_zIn != NULL) {
+					// gzread returns less than BUF_SZ only at the end
+					// of the input (or -1 on error)
+					int n = gzread(_zIn, _buf, BUF_SZ);
+					if(n < 0) {
+						int errnum;
+						std::cerr << "Error reading compressed input: "
+						          << gzerror(_zIn, &errnum) << std::endl;
+						throw 1;
+					}
+					_buf_sz = (size_t)n;
 				} else {
 					assert(_in != NULL);
 					_buf_sz = fread(_buf, 1, BUF_SZ, _in);
@@ -317,6 +355,7 @@ private:
 
 	void init() {
 		_in = NULL;
+		_zIn = NULL;
 		_inf = NULL;
 		_ins = NULL;
 		_cur = _buf_sz = BUF_SZ;
@@ -327,6 +366,7 @@ private:
 
 	static const size_t BUF_SZ = 256 * 1024;
 	FILE     *_in;
+	gzFile    _zIn;
 	std::ifstream *_inf;
 	std::istream  *_ins;
 	size_t    _cur;
@@ -406,7 +446,8 @@ private:
 /**
  * Wrapper for a buffered output stream that writes characters and
  * other data types.  This class is *not* synchronized; the caller is
- * responsible for synchronization.
+ * responsible for synchronization.  Files whose names end in .gz are
+ * written gzip-compressed.
  */
 class OutFileBuf {
 
@@ -418,13 +459,8 @@ public:
 	OutFileBuf(const char *out, bool binary = false) :
 		name_(out), cur_(0), closed_(false)
 	{
-		assert(out != NULL);
-		out_ = fopen(out, binary ? "wb" : "w");
-		if(out_ == NULL) {
-			std::cerr << "Error: Could not open alignment output file " << out << std::endl;
-			throw 1;
-		}
-		if(setvbuf(out_, NULL, _IOFBF, 10* 1024* 1024)) 
+		open(out, binary);
+		if(out_ != NULL && setvbuf(out_, NULL, _IOFBF, 10* 1024* 1024))
 			std::cerr << "Warning: Could not allocate the proper buffer size for output file stream. " << std::endl;
 	}
 
@@ -433,21 +469,25 @@ public:
 	 */
 	OutFileBuf() : name_("cout"), cur_(0), closed_(false) {
 		out_ = stdout;
+		zOut_ = NULL;
 	}
 
 	/**
 	 * Open a new output stream to a file with given name.
 	 */
 	void setFile(const char *out, bool binary = false) {
-		assert(out != NULL);
-		out_ = fopen(out, binary ? "wb" : "w");
-		if(out_ == NULL) {
-			std::cerr << "Error: Could not open alignment output file " << out << std::endl;
-			throw 1;
-		}
+		open(out, binary);
 		reset();
 	}
 
+	/**
+	 * Write len characters from s into the write buffer and, if
+	 * necessary, flush.
+	 */
+	void write(const char *s, size_t len) {
+		writeChars(s, len);
+	}
+
 	/**
 	 * Write a single character into the write buffer and, if
 	 * necessary, flush.
@@ -467,7 +507,7 @@ public:
 		if(cur_ + slen > BUF_SZ) {
 			if(cur_ > 0) flush();
 			if(slen >= BUF_SZ) {
-				size_t wlen = fwrite(s.c_str(), 1, slen, out_);
+				size_t wlen = writeOut(s.c_str(), slen);
 				if(wlen != slen) {
 					std::cerr << "Error while writing string output; " << slen
 							  << " characters in string, " << wlen
@@ -494,7 +534,7 @@ public:
 		if(cur_ + len > BUF_SZ) {
 			if(cur_ > 0) flush();
 			if(len >= BUF_SZ) {
-				size_t wlen = fwrite(s, 1, len, out_);
+				size_t wlen = writeOut(s, len);
 				if(wlen != len) {
 					std::cerr << "Error while writing string output; " << len
 							  << " characters in string, " << wlen
@@ -520,7 +560,13 @@ public:
 		if(closed_) return;
 		if(cur_ > 0) flush();
 		closed_ = true;
-		if(out_ != stdout) {
+		if(zOut_ != NULL) {
+			if(gzclose(zOut_) != Z_OK) {
+				std::cerr << "Error while flushing and closing compressed output" << std::endl;
+				throw 1;
+			}
+			zOut_ = NULL;
+		} else if(out_ != stdout) {
 			fclose(out_);
 		}
 	}
@@ -534,7 +580,7 @@ public:
 	}
 
 	void flush() {
-		if(!fwrite((const void *)buf_, cur_, 1, out_)) {
+		if(writeOut(buf_, cur_) != cur_) {
 			std::cerr << "Error while flushing and closing output" << std::endl;
 			throw 1;
 		}
@@ -557,10 +603,48 @@ public:
 
 private:
 
+	/**
+	 * Open the named file, compressed (fastest level) if the name ends
+	 * in .gz.  The output is the intermediate files of a pipeline, so
+	 * speed matters more than size.
+	 */
+	void open(const char *out, bool binary) {
+		assert(out != NULL);
+		size_t len = strlen(out);
+		out_ = NULL;
+		zOut_ = NULL;
+		if(len > 3 && strcmp(out + len - 3, ".gz") == 0) {
+			zOut_ = gzopen(out, "wb1");
+#if ZLIB_VERNUM >= 0x1240
+			if(zOut_ != NULL) gzbuffer(zOut_, 1024 * 1024);
+#endif
+		} else {
+			out_ = fopen(out, binary ? "wb" : "w");
+		}
+		if(out_ == NULL && zOut_ == NULL) {
+			std::cerr << "Error: Could not open alignment output file " << out << std::endl;
+			throw 1;
+		}
+	}
+
+	/**
+	 * Write len bytes straight to the file, return how many were
+	 * written.
+	 */
+	size_t writeOut(const char *s, size_t len) {
+		if(len == 0) return 0;
+		if(zOut_ != NULL) {
+			int n = gzwrite(zOut_, s, (unsigned)len);
+			return n > 0 ? (size_t)n : 0;
+		}
+		return fwrite(s, 1, len, out_);
+	}
+
 	static const size_t BUF_SZ = 16 * 1024;
 
 	const char *name_;
 	FILE       *out_;
+	gzFile      zOut_;
 	size_t    cur_;
 	char        buf_[BUF_SZ]; // (large) input buffer
 	bool        closed_;
@@ -841,37 +841,41 @@ protected:
 	bool sampleMax_;
 
 	// Output streams for dumping sequences
-	std::ofstream *dumpAl_;       // for single-ended reads
-	std::ofstream *dumpAl_1_;     // for first mates
-	std::ofstream *dumpAl_2_;     // for second mates
-	std::ofstream *dumpUnal_;     // for single-ended reads
-	std::ofstream *dumpUnal_1_;   // for first mates
-	std::ofstream *dumpUnal_2_;   // for second mates
-	std::ofstream *dumpMax_;      // for single-ended reads
-	std::ofstream *dumpMax_1_;    // for first mates
-	std::ofstream *dumpMax_2_;    // for second mates
+	OutFileBuf    *dumpAl_;       // for single-ended reads
+	OutFileBuf    *dumpAl_1_;     // for first mates
+	OutFileBuf    *dumpAl_2_;     // for second mates
+	OutFileBuf    *dumpUnal_;     // for single-ended reads
+	OutFileBuf    *dumpUnal_1_;   // for first mates
+	OutFileBuf    *dumpUnal_2_;   // for second mates
+	OutFileBuf    *dumpMax_;      // for single-ended reads
+	OutFileBuf    *dumpMax_1_;    // for first mates
+	OutFileBuf    *dumpMax_2_;    // for second mates
 
 	// Output streams for dumping qualities
-	std::ofstream *dumpAlQv_;     // for single-ended reads
-	std::ofstream *dumpAlQv_1_;   // for first mates
-	std::ofstream *dumpAlQv_2_;   // for second mates
-	std::ofstream *dumpUnalQv_;   // for single-ended reads
-	std::ofstream *dumpUnalQv_1_; // for first mates
-	std::ofstream *dumpUnalQv_2_; // for second mates
-	std::ofstream *dumpMaxQv_;    // for single-ended reads
-	std::ofstream *dumpMaxQv_1_;  // for first mates
-	std::ofstream *dumpMaxQv_2_;  // for second mates
+	OutFileBuf    *dumpAlQv_;     // for single-ended reads
+	OutFileBuf    *dumpAlQv_1_;   // for first mates
+	OutFileBuf    *dumpAlQv_2_;   // for second mates
+	OutFileBuf    *dumpUnalQv_;   // for single-ended reads
+	OutFileBuf    *dumpUnalQv_1_; // for first mates
+	OutFileBuf    *dumpUnalQv_2_; // for second mates
+	OutFileBuf    *dumpMaxQv_;    // for single-ended reads
+	OutFileBuf    *dumpMaxQv_1_;  // for first mates
+	OutFileBuf    *dumpMaxQv_2_;  // for second mates
 
 	/**
-	 * Open an ofstream with given name; output error message and quit
-	 * if it fails.
+	 * Open an OutFileBuf with given name; output error message and
+	 * quit if it fails.  A name ending in .gz is written compressed,
+	 * and the mate number goes before the extension in front of .gz.
 	 */
-	std::ofstream* openOf(const std::string& name,
-	                      int mateType,
-	                      const std::string& suffix)
+	OutFileBuf* openOf(const std::string& name,
+	                   int mateType,
+	                   const std::string& suffix)
 	{
 		std::string s = name;
 		size_t dotoff = name.find_last_of(".");
+		if(name.length() > 3 && name.substr(name.length()-3) == ".gz") {
+			dotoff = name.find_last_of(".", name.length()-4);
+		}
 		if(mateType == 1) {
 			if(dotoff == string::npos) {
 				s += "_1"; s += suffix;
@@ -887,8 +891,9 @@ protected:
 		} else if(mateType != 0) {
 			cerr << "Bad mate type " << mateType << endl; throw 1;
 		}
-		std::ofstream* tmp = new ofstream(s.c_str(), ios::out);
-		if(tmp->fail()) {
+		try {
+			return new OutFileBuf(s.c_str());
+		} catch(int e) {
 			if(mateType == 0) {
 				cerr << "Could not open single-ended aligned/unaligned-read file for writing: " << name << endl;
 			} else {
@@ -896,7 +901,6 @@ protected:
 			}
 			throw 1;
 		}
-		return tmp;
 	}
 
 	/**
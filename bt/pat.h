@@ -1650,10 +1650,7 @@ protected:
 		if(qfb_.isOpen()) qfb_.close();
 		while(filecur_ < infiles_.size()) {
 			// Open read
-			FILE *in;
-			if(infiles_[filecur_] == "-") {
-				in = stdin;
-			} else if((in = fopen(infiles_[filecur_].c_str(), "rb")) == NULL) {
+			if(!openFile(fb_, infiles_[filecur_])) {
 				if(!errs_[filecur_]) {
 					cerr << "Warning: Could not open read file \"" << infiles_[filecur_] << "\" for reading; skipping..." << endl;
 					errs_[filecur_] = true;
@@ -1661,13 +1658,9 @@ protected:
 				filecur_++;
 				continue;
 			}
-			fb_.newFile(in);
 			// Open quality
 			if(!qinfiles_.empty()) {
-				FILE *in;
-				if(qinfiles_[filecur_] == "-") {
-					in = stdin;
-				} else if((in = fopen(qinfiles_[filecur_].c_str(), "rb")) == NULL) {
+				if(!openFile(qfb_, qinfiles_[filecur_])) {
 					if(!errs_[filecur_]) {
 						cerr << "Warning: Could not open quality file \"" << qinfiles_[filecur_] << "\" for reading; skipping..." << endl;
 						errs_[filecur_] = true;
@@ -1675,12 +1668,36 @@ protected:
 					filecur_++;
 					continue;
 				}
-				qfb_.newFile(in);
 			}
 			return;
 		}
 		throw 1;
 	}
+	/**
+	 * Point fb at the named file, or stdin if the name is "-".  Files
+	 * ending in .gz are decompressed as they are read (this includes
+	 * BGZF files, which are gzip files of many members).  Return false
+	 * if the file couldn't be opened.
+	 */
+	static bool openFile(FileBuf& fb, const string& name) {
+		if(name == "-") {
+			fb.newFile(stdin);
+			return true;
+		}
+		if(name.length() > 3 && name.substr(name.length()-3) == ".gz") {
+			gzFile zin = gzopen(name.c_str(), "rb");
+			if(zin == NULL) return false;
+#if ZLIB_VERNUM >= 0x1240
+			gzbuffer(zin, 256 * 1024);
+#endif
+			fb.newFile(zin);
+			return true;
+		}
+		FILE *in = fopen(name.c_str(), "rb");
+		if(in == NULL) return false;
+		fb.newFile(in);
+		return true;
+	}
 	vector<string> infiles_; /// filenames for read files
 	vector<string> qinfiles_; /// filenames for quality files
 	vector<bool> errs_; /// whether we've already printed an error for each file
@@ -2864,6 +2881,152 @@ private:
 	bool color_;
 };
 
+/**
+ * Wraps another PatternSource (normally a FastqPatternSource of the
+ * reads left unmapped by the first alignment) and, instead of its
+ * reads, dispenses the split pieces of each read for Read-Split-Fly.
+ * The pieces and their names are the same as the split reads file
+ * written by srr (src/split_read_rsw.c): for each split position there
+ * is a left piece, the right piece that goes with it, and the same two
+ * with the lengths reversed, named <name>-L|R-<piece length>-<read
+ * length>.  Selected with --rsf-split <min piece length>.
+ */
+class SplitReadPatternSource : public PatternSource {
+public:
+	SplitReadPatternSource(PatternSource* src,
+	                       int minSplit,
+	                       uint32_t seed,
+	                       bool randomizeQuals = false,
+	                       const char *dumpfile = NULL,
+	                       bool verbose = false) :
+		PatternSource(seed, randomizeQuals, dumpfile, verbose),
+		src_(src),
+		minSplit_(minSplit)
+	{
+		assert(src_ != NULL);
+		assert_gt(minSplit_, 0);
+		resetPieces();
+	}
+
+	virtual ~SplitReadPatternSource() {
+		delete src_;
+	}
+
+	virtual void nextReadImpl(ReadBuf& r, uint32_t& patid) {
+		// Critical region: cur_ and the piece state are shared by
+		// all the search threads
+		lock();
+		while(leftCut_ > rightCut_) {
+			// Done with the current read (or it was too short to
+			// split); get the next one from the wrapped source
+			uint32_t srcid;
+			src_->nextRead(cur_, srcid);
+			if(cur_.empty()) {
+				unlock();
+				r.clearAll();
+				return;
+			}
+			readLen_ = (int)cur_.length();
+			leftCut_ = minSplit_;
+			rightCut_ = readLen_ - minSplit_;
+			piece_ = 0;
+		}
+		// Same order as srr: left, right, then reversed left, right
+		char side = "LRLR"[piece_];
+		int len   = (piece_ == 0 || piece_ == 3) ? leftCut_ : rightCut_;
+		int off   = (piece_ == 1) ? leftCut_ : ((piece_ == 3) ? rightCut_ : 0);
+		setPiece(r, side, len, off);
+		if(++piece_ == 4) {
+			piece_ = 0;
+			leftCut_++; rightCut_--;
+		}
+		readCnt_++;
+		patid = (uint32_t)(readCnt_-1);
+		unlock();
+	}
+
+	virtual void nextReadPairImpl(ReadBuf& ra, ReadBuf& rb, uint32_t& patid) {
+		cerr << "Error: --rsf-split does not support paired-end reads" << endl;
+		throw 1;
+	}
+
+	virtual void reset() {
+		PatternSource::reset();
+		src_->reset();
+		resetPieces();
+	}
+
+protected:
+
+	void resetPieces() {
+		readLen_ = 0;
+		leftCut_ = 1;
+		rightCut_ = 0;
+		piece_ = 0;
+	}
+
+	/**
+	 * Fill r with the piece of cur_ starting at off with length len,
+	 * named for the given side.
+	 */
+	void setPiece(ReadBuf& r, char side, int len, int off) {
+		r.color = cur_.color;
+		r.fuzzy = false;
+		r.primer = cur_.primer;
+		r.trimc = cur_.trimc;
+		r.alts = 0;
+		r.trimmed5 = r.trimmed3 = 0;
+		memcpy(r.patBufFw, cur_.patBufFw + off, len);
+		_setBegin (r.patFw, (Dna5*)r.patBufFw);
+		_setLength(r.patFw, len);
+		memcpy(r.qualBuf, cur_.qualBuf + off, len);
+		_setBegin (r.qual, (char*)r.qualBuf);
+		_setLength(r.qual, len);
+
+		// Name is the read's name followed by -side-len-readLen
+		size_t nameLen = seqan::length(cur_.name);
+		char suffix[32];
+		char *p = suffix;
+		*p++ = '-'; *p++ = side; *p++ = '-';
+		p = itoa10(len, p);
+		*p++ = '-';
+		p = itoa10(readLen_, p);
+		size_t suffixLen = p - suffix;
+		if(nameLen + suffixLen > (size_t)ReadBuf::BUF_SIZE-2) {
+			cerr << "Split read name is too long; read names must be " << (ReadBuf::BUF_SIZE-2)
+			     << " characters or fewer." << endl;
+			throw 1;
+		}
+		memcpy(r.nameBuf, cur_.nameBuf, nameLen);
+		memcpy(r.nameBuf + nameLen, suffix, suffixLen);
+		_setBegin (r.name, r.nameBuf);
+		_setLength(r.name, nameLen + suffixLen);
+
+		// FASTQ record for the piece, for --un/--al/--max
+		size_t recLen = 1 + (nameLen + suffixLen) + 1 + len + 3 + len + 1;
+		r.readOrigBufLen = 0;
+		if(recLen <= FileBuf::LASTN_BUF_SZ) {
+			char *o = r.readOrigBuf;
+			*o++ = '@';
+			memcpy(o, r.nameBuf, nameLen + suffixLen); o += nameLen + suffixLen;
+			*o++ = '\n';
+			for(int i = 0; i < len; i++) *o++ = "ACGTN"[(int)r.patBufFw[i]];
+			*o++ = '\n'; *o++ = '+'; *o++ = '\n';
+			memcpy(o, r.qualBuf, len); o += len;
+			*o++ = '\n';
+			r.readOrigBufLen = o - r.readOrigBuf;
+		}
+	}
+
+	PatternSource* src_; /// source of the whole reads
+	int minSplit_;       /// length of the smallest piece
+	ReadBuf cur_;        /// read currently being split
+	int readLen_;        /// length of cur_
+	int leftCut_;        /// length of the left piece at the current split position
+	int rightCut_;       /// length of the right piece at the current split position
+	int piece_;          /// which of the 4 pieces at this split position is next
+};
+
 /**
  * Read a Raw-format file (one sequence per line).  No quality strings
  * allowed.  All qualities are assumed to be 'I' (40 on the Phred-33
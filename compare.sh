@@ -10,7 +10,7 @@ function do_compare() {
     tolerance=$1
     shift
     whereto=$(python $DIRNAME_SCRIPT $2)
-    $COMPARE_PROG "$LINES_TO_SKIP" $tolerance $OUTNAME $@ >& /dev/null
+    $COMPARE_PROG -t $NUM_THREADS "$LINES_TO_SKIP" $tolerance $OUTNAME $@ >& /dev/null
     mv "${OUTNAME}.comparisonSummary.txt" "$whereto"
     mv "${OUTNAME}.comparedResults.txt" "$whereto"
 
@@ -19,7 +19,11 @@ timing_end() { if [ ! -z "$START_TIME" ]; then log "Duration: $(( $(date +%s) -
 #-------USER CONFIGURATION------------
 #-------Misc. Settings----------------
 RM_TEMP_FILES=1                             # set =1 to delete all intermediate files, =0 to keep them
-NUM_THREADS=4                               # The number of concurrent threads to use in the alignment steps
+NUM_THREADS=4                               # The number of concurrent threads to use in the split, alignment and split pairs steps
+SPLIT_READS_MODE=stream                     # how unmapped reads are split for re-aligning: stream (srr piped into bowtie), file (srr writes SPLIT_TEMP_DIR), or bowtie (bt/bowtie splits them itself)
+SPLIT_COLUMNS_FORMAT=bowtie                 # how re-aligned reads are passed to split pairs: bowtie (read bowtie's output directly, no sfc step), binary or text (from sfc)
+RSR_MEMORY_MB=0                             # If >0, split pairs sorts its read data on disk (in RSR_TEMP_DIR) using this many MB at a time.  This caps the read records and their sorting only; the read ids, junctions and refFlat data stay in memory on top of it
+COMPRESS_TEMP_FILES=0                       # set =1 to gzip the intermediate files (unmapped reads, split reads, bowtie output, .split1stcolumn), =0 to write them as plain text
 #-------Directories-------------------
 BOWTIE_INDEXES="${BASEDIR}/bt/indexes"      # Location where you store your bowtie indexes.
 BASE_TEMP_DIR="${BASEDIR}/tmp"
@@ -65,11 +69,18 @@ PIPELINE="${BASEDIR}/pipeline.sh"
 COMPARE_SCRIPT="${BASEDIR}/compare.sh"
 
 #pipeline.sh: Pipeline Constants
+#intermediate files are name$TEMP_SUFFIX
+if [ "$COMPRESS_TEMP_FILES" -ne 0 ]; then
+    TEMP_SUFFIX=".gz"
+else
+    TEMP_SUFFIX=""
+fi
 #Define program/script files
 ALIGN_SCRIPT="${BASEDIR}/bowtie.sh"
 MEASURE_SCRIPT="${BASEDIR}/readlength.sh"
 SPLIT_SCRIPT="${BASEDIR}/split.sh"
 RSR_SCRIPT="${BASEDIR}/splitPairs.sh"   #_SCRIPT'd for consistency
+STATS_REPORT_SCRIPT="${BASEDIR}/src/utils/stats_report.py"  # puts RSF_STATS_FILE together into the run report
 
 # BLAST Query Stuff
 BLAST_DIR="${BASE_TEMP_DIR}/blast"
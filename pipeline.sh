@@ -57,6 +57,27 @@ function split_pairs() {
     if (( $? )); then die "Failed to split pairs.Aborting."; fi
 }
 
+# split_and_align
+# does split_pairs and the phase2 align together, with srr writing the split
+# reads to a pipe that bowtie reads, so the split reads (the largest
+# intermediate file) are never written to disk.
+# inputs = genome unmappedReadsFile minSplit maxGoodAlignments WhereToPutTheMetadata
+function split_and_align() {
+    genome=$1;
+    unmapped=$2;
+    minSplit=$3;
+    maxGood=$4;
+    dest=$5
+    log "SPLIT+ALIGN: $genome $unmapped $minSplit $maxGood"
+    result=$(set -o pipefail; $SPLIT_PROGRAM "$unmapped" $minSplit --stdout -p $NUM_THREADS 2>> "$LOG_FILE" |
+             $ALIGN_SCRIPT $genome phase2 - $maxGood "$unmapped")
+    if (( $? )); then die "Failed to split and align. Aborting."; fi
+    if [ -f "${result}.bowtie.out" ]; then
+        cp "${result}".bowtie.out $dest
+    fi
+    echo $result
+}
+
 #Temporarily out of service
 #input: bowtie_output_base_name(s)
 #function split_columns() {
@@ -82,18 +103,43 @@ function split_pairs() {
 # filename. this reduces the creep of extensions.
 function split_columns() {
     file=$1
-    if [ ! -f "${file}.bowtie.txt" ]; then
+    if [ ! -f "${file}.bowtie.txt$TEMP_SUFFIX" ]; then
         die "No bowtie file for ${file}. Cannot continue."
     fi
-    try $FORMAT_PROGRAM "${file}.bowtie.txt" >> "${LOG_FILE}" 2>&1
+    if [ "$SPLIT_COLUMNS_FORMAT" = "bowtie" ]; then
+        # split pairs reads the bowtie output itself
+        echo "${file}.bowtie.txt$TEMP_SUFFIX"
+        return
+    elif [ "$SPLIT_COLUMNS_FORMAT" = "binary" ]; then
+        # never compressed, split pairs reads it in place
+        formatopts="-b"
+        results="${file}.bowtie.txt.split1stcolumn.bin"
+    elif [ -n "$TEMP_SUFFIX" ]; then
+        formatopts="-z"
+        results="${file}.bowtie.txt.split1stcolumn$TEMP_SUFFIX"
+    else
+        formatopts=""
+        results="${file}.bowtie.txt.split1stcolumn"
+    fi
+    try $FORMAT_PROGRAM $formatopts "${file}.bowtie.txt$TEMP_SUFFIX" >> "${LOG_FILE}" 2>&1
     if (( $? )); then die "Failed to split columns. Aborting"; fi
-    if [ ! -f "${file}.bowtie.txt.split1stcolumn" ]; then
+    if [ ! -f "$results" ]; then
         die "Failed to generate formatted data for ${file}"
     fi
-    results="${file}.bowtie.txt.split1stcolumn"
     echo $results
 }
 
+# stage_stats
+# adds the wall time of a step of the pipeline to $RSF_STATS_FILE, in the same
+# form as the programs' statistics (see src/rsf_stats.h), so bowtie and the
+# scripts show up in the run report as well.
+# inputs = stageName startTime
+#        startTime = when the step started, from date +%s.%N
+function stage_stats() {
+    echo "$1 $2 $(date +%s.%N)" |
+        awk '{ printf "{\"program\":\"pipeline.sh\",\"phase\":\"%s\",\"wall_sec\":%.3f}\n", $1, $3 - $2 }' >> "$RSF_STATS_FILE"
+}
+
 # RSR
 # this is the thing. it does the heavy lifting
 #input: genome readsfile readlength minsplitsize minsplitdist maxsplitdist regionbuffer requiredSuppoerts pathtosaveresults
@@ -122,6 +168,13 @@ maxGood=$3
 destination=$9
 eValue=${10}
 
+#each program adds the statistics for its phases to RSF_STATS_FILE, and they
+#are put together into the run report at the end
+statsbase=$(python $BASENAME_SCRIPT "$(echo "$reads" | cut -d, -f1 | cut -d"|" -f1)")
+export RSF_STATS_FILE="${LOG_DIR}/RSF_${RUN_ID}.${statsbase%.gz}.stats.jsonl"
+rm -f "$RSF_STATS_FILE"
+pipeline_start=$(date +%s.%N)
+
 log "Preparing read info" 
 #pop the genome, reads file, bowtie param (maxgood) off
 #rest of params are for rsw
@@ -136,39 +189,69 @@ log "length of reads $readlength"
 
 #step 1: Align original reads
 log "Aligning reads... " 
+stage_start=$(date +%s.%N)
 results=$(align $genome phase1 $reads $maxGood $destination )
+stage_stats align_phase1 $stage_start
 log "bowtie results basename(s)=${results}" 
 rsfbase=$(python $BASENAME_SCRIPT $results)
 
+if [ "$SPLIT_READS_MODE" = "bowtie" ] && [ -f "${results}.unmapped.txt$TEMP_SUFFIX" ]; then
+#steps 2 and 3: bowtie splits the unmapped reads into pieces itself and re-aligns them
+log "re-aligning split reads in bowtie..." 
+export RSF_SPLIT_MIN=$1
+stage_start=$(date +%s.%N)
+results=$(align $genome phase2 "${results}.unmapped.txt$TEMP_SUFFIX" $maxGood $destination)
+stage_stats split_align_phase2 $stage_start
+unset RSF_SPLIT_MIN
+log "re-align results=${results}" 
+elif [ "$SPLIT_READS_MODE" = "stream" ] && [ -f "${results}.unmapped.txt$TEMP_SUFFIX" ]; then
+#steps 2 and 3: Split the unmapped reads into pieces, piped into bowtie to re-align them
+log "splitting into pairs and re-aligning reads..." 
+stage_start=$(date +%s.%N)
+results=$(split_and_align $genome "${results}.unmapped.txt$TEMP_SUFFIX" $1 $maxGood $destination)
+stage_stats split_align_phase2 $stage_start
+log "re-align results=${results}" 
+else
 #step 2: Split the unmapped reads into pieces
 log "splitting into pairs..." 
 #Note: going to assume that all reads are of the same length.
 #TODO: maybe change this to individual splits for individual read lengths?
+stage_start=$(date +%s.%N)
 results=$(split_pairs "${results}" $1 $readlength )
+stage_stats split $stage_start
 log "split results=${results}" 
 
 #step 3: re-align the split reads
 log "Re-aligning reads... " 
+stage_start=$(date +%s.%N)
 results=$(align $genome phase2 ${results} $maxGood $destination)
+stage_stats align_phase2 $stage_start
 log "re-align results=${results}" 
+fi
 
 #TODO: Possibly integrate split bowtie column here.
 # if (( $(du -m ${results}) > 50000 )); then try do_chrom_split ${results}; fi
 #step 4: split the column into proper format
 log "formatting..." 
+stage_start=$(date +%s.%N)
 results=$(split_columns ${results})
+stage_stats format $stage_start
 log "done formatting; result=$results" 
 
 
 #step 5: select candidates
 log "running rsr..."
+stage_start=$(date +%s.%N)
 result=$($RSR_SCRIPT $genome "$results" $readlength $@)
+stage_stats split_pairs $stage_start
 echo $result
 
 #step 6: Add spliced sequences to results in a new file
 log "adding spliced sequences now..."
 #${BOWTIE_INSPECT_RSR} -f ${destination}/*.results -o default ${BOWTIE_INDEXES}/${genome}
+stage_start=$(date +%s.%N)
 ${BOWTIE_INSPECT_RSR} -f $result -o default ${BOWTIE_INDEXES}/${genome}
+stage_stats splice_sequences $stage_start
 log "done adding spliced sequences."
 
 #step 7: Run miRNA and u12db blasts
@@ -177,7 +260,9 @@ log "done adding spliced sequences."
 if [ $eValue != "0" ]; then
   log "creating BLAST db and running queries..."
   log "Running ${BLAST_SCRIPT} $(python $DIRNAME_SCRIPT $result) ${eValue}"
+  stage_start=$(date +%s.%N)
   ${BLAST_SCRIPT} $(python $DIRNAME_SCRIPT $result) ${eValue}
+  stage_stats blast $stage_start
   log "done running BLAST queries."
 else
   #log "Not running BLAST queries because e-value parameter <= 0"
@@ -192,3 +277,12 @@ if [ $RM_TEMP_FILES -ne 0 ]; then
   rm -f ${RSR_TEMP_DIR}/${rsfbase}*
   log "finished deleting intermediate files"
 fi
+
+#step 9: put the statistics together into the run report
+stage_stats total $pipeline_start
+report="${destination}/${statsbase%.gz}.run_report.json"
+if python $STATS_REPORT_SCRIPT "$RSF_STATS_FILE" > "$report"; then
+  log "run report written to $report"
+else
+  log "could not write the run report from $RSF_STATS_FILE"
+fi
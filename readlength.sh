@@ -6,5 +6,5 @@ source "${BASEDIR}/config.sh"
 if (( $# < 1 )); then
     die "usage  -- $0 <reads file>"
 else
-    echo $(( $(head -2 $1 | tail -1 | wc -c) - $OFFSET ))
+    echo $(( $(gzip -dcf $1 | head -2 | tail -1 | wc -c) - $OFFSET )) # reads may be .gz
 fi
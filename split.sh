@@ -12,9 +12,11 @@ function n_split() {
     else
         output=$LOG_FILE
     fi
-    $SPLIT_PROGRAM "$1" "$2" "$SPLIT_TEMP_DIR" >> $output
-    log "n_split:: ${SPLIT_TEMP_DIR}/$(python $BASENAME_SCRIPT $1).split"
-    echo "${SPLIT_TEMP_DIR}/$(python $BASENAME_SCRIPT $1).split"
+    if [ -n "$TEMP_SUFFIX" ]; then compress="-z"; else compress=""; fi
+    $SPLIT_PROGRAM "$1" "$2" "$SPLIT_TEMP_DIR" -p $NUM_THREADS $compress >> $output
+    #srr names the output of name.gz name.split
+    log "n_split:: ${SPLIT_TEMP_DIR}/$(python $BASENAME_SCRIPT ${1%.gz}).split$TEMP_SUFFIX"
+    echo "${SPLIT_TEMP_DIR}/$(python $BASENAME_SCRIPT ${1%.gz}).split$TEMP_SUFFIX"
 }
 
 #input: resultsFileBase minimum-cut-size readsLength 
@@ -26,17 +28,17 @@ function split_pairs() {
     #    start=$(( $len - $start ))
     #fi
     log "split_pairs::file=$1,start=$2,TERM=$TERM"
-    if [ -f "${base}.unmapped.txt" ]; then
-        result=$(try n_split "${base}.unmapped.txt" $start)
-    elif [ -f "${base}.unmapped_1.txt" ] && [ -f "${base}.unmapped_2.txt" ]; then
+    if [ -f "${base}.unmapped.txt$TEMP_SUFFIX" ]; then
+        result=$(try n_split "${base}.unmapped.txt$TEMP_SUFFIX" $start)
+    elif [ -f "${base}.unmapped_1.txt$TEMP_SUFFIX" ] && [ -f "${base}.unmapped_2.txt$TEMP_SUFFIX" ]; then
         #tmp=$(try n_split "${base}.unmapped_1.txt" $start $(( $len - $start ))  )  # why was it len-start, does that matter on replicates?
-        tmp=$(try n_split "${base}.unmapped_1.txt" $start  )
-        mv "$tmp" "${tmp}-1.txt"
-        result="${tmp}-1.txt"
+        tmp=$(try n_split "${base}.unmapped_1.txt$TEMP_SUFFIX" $start  )
+        mv "$tmp" "${tmp%.gz}-1.txt$TEMP_SUFFIX"
+        result="${tmp%.gz}-1.txt$TEMP_SUFFIX"
         #tmp=$(try n_split "${base}.unmapped_2.txt" $start $(( $len - $start ))  )  # why was it len-start, does that matter on replicates?  why not just len?
-        tmp=$(try n_split "${base}.unmapped_2.txt" $start  )
-        mv "$tmp" "${tmp}-2.txt"
-        result+="|${tmp}-2.txt"
+        tmp=$(try n_split "${base}.unmapped_2.txt$TEMP_SUFFIX" $start  )
+        mv "$tmp" "${tmp%.gz}-2.txt$TEMP_SUFFIX"
+        result+="|${tmp%.gz}-2.txt$TEMP_SUFFIX"
     else
         die "split_pairs::Don't know what do do with $base"
     fi
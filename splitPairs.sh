@@ -61,7 +61,11 @@ function run_rsw() {
         else
             logfile="${LOG_FILE}"
         fi
-        try $RSR_PROGRAM "$OPTSFILE" >> $logfile
+        memopts=""
+        if [ -n "$RSR_MEMORY_MB" ] && [ "$RSR_MEMORY_MB" -gt 0 ]; then
+            memopts="--memory $RSR_MEMORY_MB --temp-dir $RSR_TEMP_DIR"
+        fi
+        try $RSR_PROGRAM "$OPTSFILE" --threads $NUM_THREADS $memopts >> $logfile
         if [ ! -f "${OUTPUTFILE}.results" ]; then
             log "Panic! rsw failed to generate output file. Check stderr." 
             exit 1
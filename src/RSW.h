@@ -17,28 +17,187 @@
 #ifndef RSW_H_
 #define RSW_H_
 
+#include <vector>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*
+  Used to store each different string (read ids, chromosome and gene names)
+  only once.  Each different string gets a 32-bit id, numbered 0, 1, 2, ...
+  in the order they are first seen, and records store the id rather than the
+  string.  Two ids are the same exactly when the strings are the same.
+
+  The strings are packed one after another into large blocks (an "arena"),
+  and looked up with an open-addressing hash table of ids, so there is no
+  memory allocated per string.  Not thread-safe.
+
+  There can be at most MAX_STRINGS strings, so ids fit in 31 bits: they
+  are packed into 64 bit sort keys along with a strand bit or a position
+  (idKey and chromPosKey below, and the junction key in splitPairs.cpp).  Adding more is an error
+  rather than ids silently colliding in those keys.
+*/
+class RSW_stringPool {
+ public:
+  RSW_stringPool() : blockUsed(0), blockSize(0), blockBytes(0) {
+    slots.assign(1024, 0);
+  }
+
+  ~RSW_stringPool() {
+    for(size_t i=0; i < blocks.size(); i++) free(blocks[i]);
+  }
+
+  // return id of the string s[0..len-1], adding it if not already there.
+  unsigned int intern(const char *s, size_t len) {
+    size_t mask = slots.size()-1;
+    size_t h = hash(s, len) & mask;
+    while (slots[h] != 0) {
+      const char *t = strings[slots[h]-1];
+      // strncmp, not memcmp: t may be shorter than len and end its block
+      if (strncmp(t, s, len) == 0 && t[len] == '\0') return slots[h]-1;
+      h = (h+1) & mask;
+    }
+
+    if (strings.size() >= MAX_STRINGS) {
+      printf("ERROR, more than %u different read ids and names, too many for the string table.\n",
+             MAX_STRINGS);
+      exit(0);
+    }
+    unsigned int id = strings.size();
+    strings.push_back(copy(s, len));
+    slots[h] = id+1;
+    if (strings.size() * 10 > slots.size() * 7) grow();
+    return id;
+  }
+
+  unsigned int intern(const char *s) { return intern(s, strlen(s)); }
+
+  static const unsigned int MAX_STRINGS = 1u << 31;
+
+  // the string with the given id
+  const char * str(unsigned int id) const { return strings[id]; }
+
+  // number of different strings
+  size_t size() const { return strings.size(); }
+
+  // memory used by the strings and the tables
+  size_t bytesUsed() const {
+    return blockBytes + strings.capacity() * sizeof(const char *) +
+      slots.capacity() * sizeof(unsigned int);
+  }
+
+ private:
+  static const size_t BLOCK_SIZE = 1 << 24;
+
+  std::vector<char *> blocks;          // the arena
+  size_t blockUsed, blockSize;         // bytes used/available in the last block
+  size_t blockBytes;                   // total bytes in all blocks
+  std::vector<const char *> strings;   // id -> string
+  std::vector<unsigned int> slots;     // hash table, id+1 or 0 if empty
+
+  static size_t hash(const char *s, size_t len) {
+    size_t h = 14695981039346656037UL; // FNV-1a
+    for(size_t i=0; i < len; i++) {
+      h ^= (unsigned char) s[i];
+      h *= 1099511628211UL;
+    }
+    return h;
+  }
+
+  // copy string into the arena, starting a new block if needed
+  const char * copy(const char *s, size_t len) {
+    if (blockUsed + len + 1 > blockSize) {
+      blockSize = len + 1 > BLOCK_SIZE ? len + 1 : BLOCK_SIZE;
+      char *block = (char *) malloc(blockSize);
+      if (block == NULL) { printf("ERROR, malloc failed, maybe out of memory.\n"); exit(0); }
+      blocks.push_back(block);
+      blockBytes += blockSize;
+      blockUsed = 0;
+    }
+    char *t = blocks.back() + blockUsed;
+    memcpy(t, s, len); t[len] = '\0';
+    blockUsed += len + 1;
+    return t;
+  }
+
+  // double the size of the hash table
+  void grow() {
+    std::vector<unsigned int> bigger(slots.size() * 2, 0);
+    size_t mask = bigger.size()-1;
+    for(unsigned int id=0; id < strings.size(); id++) {
+      size_t h = hash(strings[id], strlen(strings[id])) & mask;
+      while (bigger[h] != 0) h = (h+1) & mask;
+      bigger[h] = id+1;
+    }
+    slots.swap(bigger);
+  }
+};
+
 /*
   Used to store an RSW record when it's read off of disk into memory.
   Only the fields that are needed for determining matched pairs and supporting
-  reads are kept.
+  reads are kept, packed into 20 bytes since there is one of these for every
+  alignment of a piece of a read.  side, direction and splitPos are computed
+  from the packed fields.
 */
 class RSW {
  public:
-  const char *id; // pointer to id of strand
-  char side;      // from left or right side of splitting a read
-  int length;     // number of base pairs of this split
-  int totalReadLength; // total length of the read this split is in
-  char direction; // which strand/direction the match of this split is on
-  const char *chromosome; // pointer to which chromosome
-  long int position;      // position on chromosome where split matches
-  long int splitPos;      // where is the split - could be either end depending on direction
-  const char * halfKey;
-  const char * otherHalfKey;
-  int count; // not currently used
-  int hash;  // not currently used
-  const char *sequence; // sequence
+  unsigned int id;         // id of strand, in string table
+  unsigned int chromosome; // which chromosome, in string table
+  unsigned int position;   // position on chromosome where split matches
+  unsigned int length : 15;          // number of base pairs of this split
+  unsigned int totalReadLength : 15; // total length of the read this split is in
+  unsigned int rightSide : 1;   // 1 if from right side of splitting a read, 0 if from left
+  unsigned int minusStrand : 1; // 1 if the match of this split is on the - strand, 0 if +
+  unsigned short otherHalfMaxLength; // longest piece of the other side of this read, 0 if none
+
+  char side() const { return rightSide ? 'R' : 'L'; }
+  char direction() const { return minusStrand ? '-' : '+'; }
+
+  // where is the split - could be either end depending on direction
+  long int splitPos() const {
+    if (rightSide == minusStrand) return (long int) position + length;
+    else return position;
+  }
+
+  // true if no piece from the other side of this read is long enough to make up
+  // the rest of the read (presumably because it is in the max file).
+  bool otherHalfMissing() const {
+    return otherHalfMaxLength == 0 || otherHalfMaxLength < totalReadLength - length;
+  }
 };
 
+/*
+  Function:   compare_dataById, used for sorting input data
+
+  Sorts based on id, direction, chromosome, position.  The first three are
+  packed into one 64 bit key (string table ids are less than 2^31, which
+  RSW_stringPool::intern enforces).
+*/
+static inline unsigned long long idKey(RSW const &r) {
+  return ((unsigned long long) r.id << 32) | ((unsigned long long) r.minusStrand << 31) | r.chromosome;
+}
+
+inline bool compare_dataById(RSW const &aa, RSW const &bb) {
+  unsigned long long ka = idKey(aa), kb = idKey(bb);
+  if (ka != kb) return ka < kb;
+  return aa.position < bb.position;
+}
+
+/*
+  Function:   compare_dataToSort, used for sorting input data
+
+  Sorts based on chromosome, position of the split, packed into one 64 bit key.
+*/
+static inline unsigned long long chromPosKey(RSW const &r) {
+  return ((unsigned long long) r.chromosome << 33) | (unsigned long long) r.splitPos();
+}
+
+inline bool compare_dataByChromPos(RSW const &aa, RSW const &bb) {
+  return chromPosKey(aa) < chromPosKey(bb);
+}
+
 // min and max length seen for a given id and half (either L or R)
 class RSW_half_data {
  public:
@@ -52,9 +211,9 @@ class RSW_half_data {
 */
 class RSW_Known {
  public:
-  const char *id1; // pointer to name of gene
-  const char *id2; // unused
-  const char *chromosome; // chromosome gene is on
+  unsigned int id1; // name of gene, in string table
+  unsigned int id2; // unused
+  unsigned int chromosome; // chromosome gene is on, in string table
   char direction;         // which direction
   long int position1;     // start of gene
   long int position2;     // end of gene
@@ -66,9 +225,9 @@ class RSW_Known {
 */
 class RSW_Boundaries {
  public:
-  const char *id1;
-  const char *id2;
-  const char *chromosome;
+  unsigned int id1;
+  unsigned int id2;
+  unsigned int chromosome;
   char direction;
   long int length;
   long int position1;
@@ -82,10 +241,10 @@ class RSW_Boundaries {
 */
 class RSW_splice {
  public:
-  const char * id;       // id of a read this junction is based on
-  const char * geneName; //
+  unsigned int id;       // id of a read this junction is based on, in string table
+  unsigned int geneName; // in string table
   int geneUnknown;       // is this junction within a gene or outside of known genes
-  const char * chromosome;
+  unsigned int chromosome; // in string table
   char direction;
   long int positionSmaller; // one end of the junction
   long int positionLarger;  // other end of the junction
@@ -110,8 +269,8 @@ class RSW_splice {
 */
 class RSW_result {
  public:
-  const char * geneName;
-  const char * chromosome;
+  unsigned int geneName;   // in string table
+  unsigned int chromosome; // in string table
   long int supportCount; // how many reads supported this junction
   long int spliceLength; // number of base pairs spliced out
   long int minSmallSupport; // from RSW_splice record
@@ -121,6 +280,33 @@ class RSW_result {
 
 
 
+/*
+  Function: part_starts, split the indexes 0 .. n-1 into about numParts parts
+            of the same size, for working on them in parallel.
+
+  Parameters: sameGroup(i) - true if index i must be in the same part as i-1
+              (in splitPairs, the records of one read id), so a part start
+              is moved forward until it is false.
+
+  Return: where each part starts, followed by n.  A start moved onto the
+          next one (or onto n) is dropped, so there can be fewer than
+          numParts parts.
+          Indexes are size_t since the read data can have more than 2^31
+          records.
+*/
+std::vector<size_t> part_starts(size_t n, int numParts, std::function<bool(size_t)> sameGroup) {
+  std::vector<size_t> starts;
+  for(int p=0; p < numParts; p++) {
+    size_t start = n / numParts * p + n % numParts * p / numParts;
+    while (start > 0 && start < n && sameGroup(start))
+      start++;
+    if (starts.size() == 0 || (start > starts.back() && start < n))
+      starts.push_back(start);
+  }
+  starts.push_back(n);
+  return starts;
+}
+
 /*
   Function: get_line, read a line from a file, removing newline character
 
@@ -0,0 +1,102 @@
+/*
+  File:            RSW_binary.h
+
+  Copyright 2015 Jeff Kinne, Yongheng Bai, Brandon Donham.
+  Permission to use for academic, non-profit purposes is granted, in which case this
+  copyright notice should be maintained and original authors acknowledged.
+
+  Version history: Not tracked in this file, see splitPairs.cpp, split_columns.c
+                   and compare.cpp
+
+  Contents:        Binary format for the aligned split reads, written by
+                   split_columns.c (sfc -b) and read by splitPairs.cpp (sp4).
+                   Plain C so it can be included by both.
+
+                   Binary format for the junction by sample matrix written by
+                   compare -b, below.
+
+  The file holds the same information sp4 uses from the text .split1stcolumn
+  file, one column at a time so that sp4 can memory-map it and read it in
+  place without parsing any text:
+
+    RSW_binaryHeader
+    uint32_t id[numRecords]             read id, index into the strings
+    uint32_t chromosome[numRecords]     chromosome, index into the strings
+    uint32_t position[numRecords]       position on chromosome
+    uint16_t length[numRecords]         length of the piece of the read
+    uint16_t totalReadLength[numRecords]
+    uint8_t  flags[numRecords]          RSW_BINARY_RIGHT_SIDE, RSW_BINARY_MINUS_STRAND
+    char     strings[stringBytes]       numStrings '\0' terminated strings
+
+  Each different read id and chromosome name is stored once in strings,
+  numbered 0, 1, 2, ... in the order they appear.  Numbers are in the byte
+  order of the machine that wrote the file, so the file is only meant to be
+  used on the machine that made it, as an intermediate file in the pipeline.
+*/
+
+#ifndef RSW_BINARY_H_
+#define RSW_BINARY_H_
+
+#include <stdint.h>
+
+#define RSW_BINARY_MAGIC "RSWBIN1"   /* 8 bytes including the '\0' */
+#define RSW_BINARY_SUFFIX ".bin"     /* added by sfc -b after .split1stcolumn */
+
+#define RSW_BINARY_RIGHT_SIDE   1
+#define RSW_BINARY_MINUS_STRAND 2
+
+struct RSW_binaryHeader {
+  char magic[8];
+  uint64_t numRecords;
+  uint64_t numStrings;
+  uint64_t stringBytes;
+};
+
+/* size of the whole file, given the header */
+#define RSW_BINARY_FILE_SIZE(h) \
+  (sizeof(struct RSW_binaryHeader) + (h)->numRecords * (3*4 + 2*2 + 1) + (h)->stringBytes)
+
+
+/*
+  Junction by sample matrix, written by compare -b next to its text output
+  as outputBasename.junctionMatrix.bin.  Each row is a row of the text output
+  (a junction lined up between the files, or a cluster with -c) and each
+  column is one of the results files:
+
+    RSW_matrixHeader
+    uint32_t count[numJunctions][numSamples]  supporting reads, one row at a time,
+                                              0 if the junction is not in the sample
+    uint32_t geneName[numJunctions]           index into the strings
+    uint32_t chromosome[numJunctions]         index into the strings
+    uint32_t spliceLength[numJunctions]
+    uint32_t minSmallSupport[numJunctions]    range of supporting reads, over all samples
+    uint32_t maxLargeSupport[numJunctions]
+    uint8_t  novel[numJunctions]              1 if novel in every sample that has it
+    char     strings[stringBytes]             numStrings '\0' terminated strings, the
+                                              first numSamples are the results files
+
+  Same byte order as the machine that wrote it.  In R, for example:
+
+    f <- file("x.junctionMatrix.bin", "rb")
+    readBin(f, "raw", 8)
+    h <- readBin(f, "integer", 4, size = 8)   # numJunctions, numSamples, ...
+    m <- matrix(readBin(f, "integer", h[1] * h[2], size = 4), ncol = h[2], byrow = TRUE)
+*/
+
+#define RSW_MATRIX_MAGIC "RSWMAT1"   /* 8 bytes including the '\0' */
+#define RSW_MATRIX_SUFFIX ".junctionMatrix.bin"
+
+struct RSW_matrixHeader {
+  char magic[8];
+  uint64_t numJunctions;
+  uint64_t numSamples;
+  uint64_t numStrings;
+  uint64_t stringBytes;
+};
+
+/* size of the whole file, given the header */
+#define RSW_MATRIX_FILE_SIZE(h) \
+  (sizeof(struct RSW_matrixHeader) + (h)->numJunctions * ((h)->numSamples * 4 + 5*4 + 1) + \
+   (h)->stringBytes)
+
+#endif
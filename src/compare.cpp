@@ -12,9 +12,9 @@
 	      for determining junctions that are present in one version of an experiment
 	      and not in another.
 
-  To compile: g++ compare.cpp -o comp -O4
+  To compile: g++ compare.cpp -o comp -O4 -std=c++11 -pthread
 
-  To run:     ./comp linesToSkip supportPosTolerance outputBasename file1 file2 file3 ...
+  To run:     ./comp [-c] [-b] [-t threads] linesToSkip supportPosTolerance outputBasename file1 file2 file3 ...
               The files are assumed to be results files produced
 	      by the splitPairs.cpp program.  See that file for 
 	      the file format.  
@@ -31,6 +31,15 @@
 	      outPutBasename is the base filename for output files - the output
 	      summary files are outPutBasename.comparedResults.txt and outPutBasename.comparisonSummary.txt
 
+	      -c clusters the junctions of all the files instead (see cluster_results),
+	      and writes outPutBasename.junctionMatrix.txt in place of comparedResults -
+	      one row per cluster, with the number of supporting reads from each file.
+
+	      -b also writes outPutBasename.junctionMatrix.bin, the rows of either one
+	      as a binary matrix of supporting reads (format in RSW_binary.h).
+
+	      -t reads and sorts that many results files at once.
+
   Version history...  Note - executable saved as comp, comp2, comp3, ... (+1 each time testing/debugging a new version)
 
     8/15/2015 - RSR version 1.0.0 on github
@@ -40,6 +49,28 @@
     8/6/2015 - add another column to summary that says the max support of any junction.
 
     8/6/2015 - add another column to summary that shows the total number of known+novel junctions in each file.
+
+    10/16/2026 - write the time and memory used, bytes and records of reading
+    and of comparing the results files to $RSF_STATS_FILE (see rsf_stats.h).
+
+    10/16/2026 - gene and chromosome names are kept once in a string table.
+    Each file is sorted on its own and saved to a temporary file, and the
+    files are merged with a heap of the record each file is at, instead of
+    sorting all the records together and keeping a set of the ones printed.
+    Only one file is in memory at a time.
+
+    10/16/2026 - add -c, to cluster the junctions of many samples and write a
+    junction by sample matrix.  Lining up junctions with the next one of each
+    file depends on the order of the files when supportPosTolerance > 0, and
+    can split a junction over several rows.
+
+    10/16/2026 - add -b, to also write the rows as a binary junction by sample
+    matrix with the junctions' genes, positions and names (see RSW_binary.h),
+    so the counts can be read without parsing the text.
+
+    10/16/2026 - add -t, to read and sort the results files on several threads.
+    Each file is read with one fread and split into lines in place, instead
+    of a character at a time with get_line.
 */
 
 #include <stdio.h>
@@ -52,13 +83,111 @@
 #include <algorithm>
 #include <time.h>
 #include <unordered_map>
-#include <set>
+#include <thread>
+#include <atomic>
+#include <functional>
 
 using namespace std;
 
 #include "RSW.h"
+#include "RSW_binary.h"
+#include "rsf_stats.h"
+
+// gene and chromosome names, results records hold their ids
+RSW_stringPool stringTable;
+
+/*
+  One results file, sorted and written to a temporary file by main, then
+  read back one record at a time while merging the files.
+ */
+class RSW_resultStream {
+ public:
+  FILE *f;
+  RSW_result head;  // record the stream is currently at
+  long int count;   // number of records in the file
+  RSW_stringPool *names;   // names of this file, the file's records are numbered by these
+  vector<unsigned int> id; // id in stringTable of each of names
+
+  // move to the next record, false if there are no more
+  bool next() {
+    if (fread(&head, sizeof(RSW_result), 1, f) != 1) return false;
+    head.geneName = id[head.geneName];
+    head.chromosome = id[head.chromosome];
+    return true;
+  }
+};
+
+RSW_resultStream *streams;
 
-vector<RSW_result *> *results;
+/*
+  Junction by sample matrix written with -b, see RSW_binary.h.  The counts are
+  written a row at a time as the rows are made, the other columns are kept in
+  memory until close.
+ */
+class RSW_matrixFile {
+ public:
+  FILE *f;
+  struct RSW_matrixHeader h;
+  vector<uint32_t> geneName, chromosome, spliceLength, minSmallSupport, maxLargeSupport;
+  vector<uint8_t> novel;
+
+  RSW_matrixFile(const char *filename, int numSamples) {
+    f = fopen(filename, "wb");
+    if (f == NULL) {
+      printf("Unable to open file %s for writing.\n", filename);
+      exit(1);
+    }
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, RSW_MATRIX_MAGIC, sizeof(h.magic));
+    h.numSamples = numSamples;
+    fwrite(&h, sizeof(h), 1, f); // filled in by close
+  }
+
+  // add a row, first is the junction the row is for (gene and chromosome are
+  // numbered after the sample names in the strings)
+  void addRow(RSW_result const &first, long int maxLarge, bool isNovel, vector<uint32_t> const &count) {
+    fwrite(count.data(), sizeof(uint32_t), count.size(), f);
+    geneName.push_back(h.numSamples + first.geneName);
+    chromosome.push_back(h.numSamples + first.chromosome);
+    spliceLength.push_back(first.spliceLength);
+    minSmallSupport.push_back(first.minSmallSupport);
+    maxLargeSupport.push_back(maxLarge);
+    novel.push_back(isNovel);
+    h.numJunctions++;
+  }
+
+  // write the rest of the file, return its size
+  long int close(char **sampleNames) {
+    fwrite(geneName.data(), sizeof(uint32_t), h.numJunctions, f);
+    fwrite(chromosome.data(), sizeof(uint32_t), h.numJunctions, f);
+    fwrite(spliceLength.data(), sizeof(uint32_t), h.numJunctions, f);
+    fwrite(minSmallSupport.data(), sizeof(uint32_t), h.numJunctions, f);
+    fwrite(maxLargeSupport.data(), sizeof(uint32_t), h.numJunctions, f);
+    fwrite(novel.data(), sizeof(uint8_t), h.numJunctions, f);
+
+    unsigned int i;
+    for(i=0; i < h.numSamples; i++) {
+      fwrite(sampleNames[i], 1, strlen(sampleNames[i])+1, f);
+      h.stringBytes += strlen(sampleNames[i])+1;
+    }
+    for(i=0; i < stringTable.size(); i++) {
+      fwrite(stringTable.str(i), 1, strlen(stringTable.str(i))+1, f);
+      h.stringBytes += strlen(stringTable.str(i))+1;
+    }
+    h.numStrings = h.numSamples + stringTable.size();
+
+    rewind(f);
+    fwrite(&h, sizeof(h), 1, f);
+    if (ferror(f)) {
+      printf("Error writing junction matrix.\n");
+      exit(1);
+    }
+    fclose(f);
+    return RSW_MATRIX_FILE_SIZE(&h);
+  }
+};
+
+RSW_matrixFile *matrix = NULL; // with -b
 
 // counts of the number of novel/known junctions, and max support for any junction.
 // pointers to arrays - these are counts for all files.
@@ -66,86 +195,93 @@ int *myNovelCount, *myKnownCount, *maxSupportNum;
 
 // parameters that come off the command line
 int numResultsFiles, 
-  supportPosTolerance;
-
-// keep track of junctions that have already been printed - used in lining up 
-// junctions betwen results files
-set<RSW_result *> alreadyPrinted;
-
+  supportPosTolerance,
+  linesToSkip,
+  numThreads = 1; // from -t
+char **resultsFiles;
 
-char sLine[MAX_LINE+1];
-
-char temp[MAX_LINE+1];
 
 /*
   Function:   read_results, reads a results file from disk into memory.
 
   Parameters: lineToSkip - off the command line, filename - file to open, data_results - 
-              vector to store results records into.
+              vector to store results records into, names - string table for the
+              gene and chromosome names of this file.
+
+  The whole file is read with one fread and split into lines in place.  Called
+  from several threads at once for different files.
 
   If can't open file, print error message and abort program.
  */
-void read_results(int linesToSkip, const char *filename, vector<RSW_result *> &data_results) {
+void read_results(int linesToSkip, const char *filename, vector<RSW_result> &data_results,
+                  RSW_stringPool &names) {
   FILE * f = fopen(filename, "r");
   if (f == NULL) {printf("Error reading from file %s\n", filename); exit(0); }
+
+  fseek(f, 0, SEEK_END);
+  long int size = ftell(f);
+  rewind(f);
+  char *buf = (char *)malloc(size+1);
+  if (buf == NULL || fread(buf, 1, size, f) != size) {
+    printf("Error reading from file %s\n", filename);
+    exit(0);
+  }
+  buf[size] = '\0';
+  fclose(f);
   
-  int result=1; int lineNo=0;
-  while (result > 0) {
-    int i; char dir;
+  char *line = buf, *end = buf+size; int lineNo=0;
+  while (line <= end) {
+    int i; char *save;
 
-    RSW_result * rs = new RSW_result; // new record to store a line into
+    RSW_result rs; // new record to store a line into
 
     // get a line
-    result = get_line(f, sLine, MAX_LINE);
-    if (result < 0) {
-      printf("Error reading results file %s, line exceeded %i characters.\n", filename, MAX_LINE);
-      break;
-    }
+    char *eol = (char *)memchr(line, '\n', end-line);
+    if (eol == NULL) eol = end;
+    *eol = '\0';
+    char *sLine = line;
+    line = eol+1;
     lineNo++;
     if (lineNo <= linesToSkip) continue; // skip past a certain number of lines that aren't records
 
     // loop through line, split into fields separated by tabs
-    char *temp = strtok(sLine, "\t");
-    char *temp1; char *sTemp;
+    char *temp = strtok_r(sLine, "\t", &save);
+    char *temp1;
     i=0;
     while (temp != NULL) {
       switch (i) {
         case 0: // geneName
-          sTemp = (char *)malloc((strlen(temp)+1)*sizeof(char));
-          strcpy(sTemp, temp);
-          rs->geneName = sTemp;
+          rs.geneName = names.intern(temp);
           break;
         case 1: // chromosome
-          sTemp = (char *)malloc((strlen(temp)+1)*sizeof(char));
-          strcpy(sTemp, temp);
-          rs->chromosome = sTemp;
+          rs.chromosome = names.intern(temp);
           break;
         case 2: // supportCount, either 2 or 4 for total
-          rs->supportCount = atoi(temp);
+          rs.supportCount = atoi(temp);
           break;
         case 5: // spliceLength
-          rs->spliceLength = atoi(temp);
+          rs.spliceLength = atoi(temp);
           break;
         case 6: // min/max positions of boundaries of supporting reads
           temp1 = strstr(temp, "--");
           if (temp1 == NULL) {
-            rs->minSmallSupport = rs->maxLargeSupport = 0;
+            rs.minSmallSupport = rs.maxLargeSupport = 0;
           }
           else {
             temp1[0] = '\0';
-            rs->minSmallSupport = atol(temp);
-            rs->maxLargeSupport = atol(temp1+2);
+            rs.minSmallSupport = atol(temp);
+            rs.maxLargeSupport = atol(temp1+2);
           }
           break;
         case 7: // novel or not
           if (strcmp(temp, "Novel") == 0)
-            rs->novel = true;
+            rs.novel = true;
           else 
-            rs->novel = false;
+            rs.novel = false;
           break;
       }
       i++;
-      temp = strtok(NULL,"\t");
+      temp = strtok_r(NULL, "\t", &save);
       if (temp == NULL) break;
     }
     if (i < 6) break; // should be at least 6 fields in each line
@@ -154,7 +290,19 @@ void read_results(int linesToSkip, const char *filename, vector<RSW_result *> &d
     data_results.push_back(rs);
   }
   
-  fclose(f);
+  free(buf);
+}
+
+// string table that record ids are into, the one for a single file while
+// load_results is sorting it
+thread_local const RSW_stringPool *namePool = &stringTable;
+
+/*
+  Function: compare_names, compare two names from namePool the way strcmp would
+ */
+int compare_names(unsigned int aa, unsigned int bb) {
+  if (aa == bb) return 0;
+  return strcmp(namePool->str(aa), namePool->str(bb));
 }
 
 /*
@@ -162,52 +310,361 @@ void read_results(int linesToSkip, const char *filename, vector<RSW_result *> &d
          
   Sort them based on chromosome name, gene, splice length, and # of supporting reads
  */
-bool compare_data_results(RSW_result const *aa, RSW_result const *bb) {
-  int temp = strcmp(aa->chromosome, bb->chromosome);
+bool compare_data_results(RSW_result const &aa, RSW_result const &bb) {
+  int temp = compare_names(aa.chromosome, bb.chromosome);
   if (temp < 0) return true;
   else if (temp > 0) return false;
 
-  temp = strcmp(aa->geneName, bb->geneName);
+  temp = compare_names(aa.geneName, bb.geneName);
   if (temp < 0) return true;
   else if (temp > 0) return false;
 
-  if (aa->spliceLength < bb->spliceLength) 
+  if (aa.spliceLength < bb.spliceLength) 
     return true;
-  else if (bb->spliceLength < aa->spliceLength)
+  else if (bb.spliceLength < aa.spliceLength)
     return false;
 
-  if (aa->minSmallSupport < bb->minSmallSupport) 
+  if (aa.minSmallSupport < bb.minSmallSupport) 
     return true;
 
   return false;
 }
 
+/*
+  Function: compare_cluster_results, order of the junctions for clustering them
+
+  Sort them based on chromosome name, splice length, position, and gene
+ */
+bool compare_cluster_results(RSW_result const &aa, RSW_result const &bb) {
+  int temp = compare_names(aa.chromosome, bb.chromosome);
+  if (temp < 0) return true;
+  else if (temp > 0) return false;
+
+  if (aa.spliceLength < bb.spliceLength) 
+    return true;
+  else if (bb.spliceLength < aa.spliceLength)
+    return false;
+
+  if (aa.minSmallSupport < bb.minSmallSupport) 
+    return true;
+  else if (bb.minSmallSupport < aa.minSmallSupport)
+    return false;
+
+  return compare_names(aa.geneName, bb.geneName) < 0;
+}
+
+// order the files are sorted and merged in, compare_data_results, or
+// compare_cluster_results with -c
+bool (*compare_results)(RSW_result const &aa, RSW_result const &bb) = compare_data_results;
+
 /*
   Function: overlapResult, return true/false whether the two splices overlap
   
   For true, must be on same chromosome and gene, have same splice length, and 
   be within supportPosTolerance of each other.
  */
-bool overlapResult(RSW_result const *aa, RSW_result const *bb) {
-  if (strcmp(aa->chromosome, bb->chromosome) != 0) return false;
-  if (strcmp(aa->geneName, bb->geneName) != 0) return false;
-  if (aa->spliceLength != bb->spliceLength) return false;
+bool overlapResult(RSW_result const &aa, RSW_result const &bb) {
+  if (aa.chromosome != bb.chromosome) return false;
+  if (aa.geneName != bb.geneName) return false;
+  if (aa.spliceLength != bb.spliceLength) return false;
 
-  if (abs(aa->minSmallSupport-bb->minSmallSupport) > supportPosTolerance) return false; 
+  if (abs(aa.minSmallSupport-bb.minSmallSupport) > supportPosTolerance) return false; 
 
   return true;
 }
 
+/*
+  Function: stream_after, order of the files in the merge heap - by the record each
+  file is at, and by position on the command line if those are the same.  Is "less than"
+  for a max-heap, so the file with the smallest record is on top.
+ */
+bool stream_after(int aa, int bb) {
+  if (compare_results(streams[bb].head, streams[aa].head)) return true;
+  if (compare_results(streams[aa].head, streams[bb].head)) return false;
+  return aa > bb;
+}
+
+
+/*
+  Function: merge_results, line up the junctions of the sorted results files and
+  write them to fResults, one row per junction with a column for each file.
+
+  Return: number of records merged
+ */
+long int merge_results(FILE *fResults) {
+  int i;
+
+  // merge the sorted files.  the smallest record left in any of them starts a row, and
+  // the next record of each file is printed on that row if it overlaps it.  the ones
+  // that overlap are all at the top of the heap, ahead of any that don't.
+  vector<int> heap; // files with records left
+  for(i=0; i < numResultsFiles; i++)
+    if (streams[i].next()) heap.push_back(i);
+  make_heap(heap.begin(), heap.end(), stream_after);
+
+  vector<int> rowFiles;                        // files printed on the current row
+  vector<bool> inRow(numResultsFiles, false);
+  vector<uint32_t> count(numResultsFiles, 0);  // row of the matrix with -b
+  long int numRecords = 0;
+  while (heap.size() > 0) {
+    RSW_result first = streams[heap.front()].head;
+
+    rowFiles.clear();
+    while (heap.size() > 0 && overlapResult(first, streams[heap.front()].head)) {
+      pop_heap(heap.begin(), heap.end(), stream_after);
+      rowFiles.push_back(heap.back());
+      inRow[heap.back()] = true;
+      heap.pop_back();
+    }
+
+    fprintf(fResults,"%s\t%s\t", stringTable.str(first.geneName), stringTable.str(first.chromosome));
+
+    for(i=0; i < numResultsFiles; i++) {
+      if (inRow[i]) {
+        RSW_result const &rs = streams[i].head;
+        fprintf(fResults,"%li\t%li\t%li--%li\t%s\t",
+            rs.supportCount,
+            rs.spliceLength,
+            rs.minSmallSupport,
+            rs.maxLargeSupport,
+            rs.novel ? "Novel" : "*");
+      }
+      else {
+        fprintf(fResults,"-\t-\t-\t-\t");
+      }
+    }
+    fprintf(fResults,"\n");
+
+    if (matrix != NULL) {
+      long int maxLargeSupport = first.maxLargeSupport;
+      bool novel = true;
+      for(i=0; i < rowFiles.size(); i++) {
+        RSW_result const &rs = streams[rowFiles[i]].head;
+        count[rowFiles[i]] = rs.supportCount;
+        if (rs.maxLargeSupport > maxLargeSupport) maxLargeSupport = rs.maxLargeSupport;
+        if (!rs.novel) novel = false;
+      }
+      matrix->addRow(first, maxLargeSupport, novel, count);
+      for(i=0; i < rowFiles.size(); i++)
+        count[rowFiles[i]] = 0;
+    }
+
+    // keep track of number of novel/known that are in exactly one of 
+    // the results files.
+    if (rowFiles.size() == 1) {
+      if (first.novel) myNovelCount[rowFiles[0]]++;
+      else myKnownCount[rowFiles[0]]++;
+    }
+
+    // move each printed file on to its next record
+    for(i=0; i < rowFiles.size(); i++) {
+      int f = rowFiles[i];
+      inRow[f] = false;
+      numRecords++;
+      if (streams[f].next()) {
+        heap.push_back(f);
+        push_heap(heap.begin(), heap.end(), stream_after);
+      }
+    }
+  }
+
+  return numRecords;
+}
+
+/*
+  Function: print_cluster, write one cluster as a row of the junction matrix, and
+  clear support and inCluster for the next one.
 
-// record of all results, used for keeping track of whether we've printed a given
-// junction yet or not.
-vector<RSW_result *> allResults;
+  Parameters: first - junction of the cluster with the smallest position, the
+              gene and chromosome are taken from it, maxLargeSupport - largest
+              position of the cluster, novel - whether all its junctions are novel,
+              support/inCluster - supporting reads from, and whether in cluster, for each file
+ */
+void print_cluster(FILE *fMatrix, RSW_result const &first, long int maxLargeSupport, bool novel,
+                   vector<long int> &support, vector<bool> &inCluster) {
+  int i, numSamples = 0, onlySample = -1;
+  for(i=0; i < numResultsFiles; i++)
+    if (inCluster[i]) {
+      numSamples++;
+      onlySample = i;
+    }
+
+  fprintf(fMatrix,"%s\t%s\t%li\t%li--%li\t%s\t%i",
+          stringTable.str(first.geneName), stringTable.str(first.chromosome),
+          first.spliceLength, first.minSmallSupport, maxLargeSupport,
+          novel ? "Novel" : "*", numSamples);
+  for(i=0; i < numResultsFiles; i++)
+    fprintf(fMatrix,"\t%li", support[i]);
+  fprintf(fMatrix,"\n");
+
+  if (matrix != NULL) {
+    vector<uint32_t> count(support.begin(), support.end());
+    matrix->addRow(first, maxLargeSupport, novel, count);
+  }
+
+  for(i=0; i < numResultsFiles; i++) {
+    support[i] = 0;
+    inCluster[i] = false;
+  }
+
+  // keep track of number of novel/known that are in exactly one of 
+  // the results files.
+  if (numSamples == 1) {
+    if (novel) myNovelCount[onlySample]++;
+    else myKnownCount[onlySample]++;
+  }
+}
+
+/*
+  Function: cluster_results, group the junctions of all the files into clusters and
+  write them to fMatrix as a junction by sample matrix of supporting reads.
+
+  Junctions are taken in order of chromosome, splice length and position, and one
+  is put in the current cluster if it has the same chromosome and length as the
+  first junction of the cluster and its position is at most supportPosTolerance
+  past it.  So the clusters don't depend on the order of the files or of the
+  junctions in them, and don't grow by chaining together junctions that are each
+  close to the one before.  A sample with more than one junction in a cluster
+  gets the sum of their support.
+
+  Return: number of records clustered
+ */
+long int cluster_results(FILE *fMatrix) {
+  vector<int> heap; // files with records left
+  int i;
+  for(i=0; i < numResultsFiles; i++)
+    if (streams[i].next()) heap.push_back(i);
+  make_heap(heap.begin(), heap.end(), stream_after);
+
+  vector<long int> support(numResultsFiles, 0); // for each file, in the current cluster
+  vector<bool> inCluster(numResultsFiles, false);
+  RSW_result first;                             // first junction of the cluster
+  long int maxLargeSupport = 0;
+  bool novel = true;                            // novel unless some junction is known
+  int numSamples = 0;
+  long int numRecords = 0;
+  while (heap.size() > 0) {
+    pop_heap(heap.begin(), heap.end(), stream_after);
+    int f = heap.back();
+    heap.pop_back();
+    RSW_result rs = streams[f].head;
+    if (streams[f].next()) {
+      heap.push_back(f);
+      push_heap(heap.begin(), heap.end(), stream_after);
+    }
+
+    // the cluster is done, print it
+    if (numRecords > 0 &&
+        (rs.chromosome != first.chromosome || rs.spliceLength != first.spliceLength ||
+         rs.minSmallSupport - first.minSmallSupport > supportPosTolerance)) {
+      print_cluster(fMatrix, first, maxLargeSupport, novel, support, inCluster);
+      numSamples = 0;
+    }
+
+    if (numSamples == 0) {
+      first = rs;
+      maxLargeSupport = rs.maxLargeSupport;
+      novel = true;
+    }
+    if (!inCluster[f]) {
+      inCluster[f] = true;
+      numSamples++;
+    }
+    support[f] += rs.supportCount;
+    if (rs.maxLargeSupport > maxLargeSupport) maxLargeSupport = rs.maxLargeSupport;
+    if (!rs.novel) novel = false;
+    numRecords++;
+  }
+  if (numRecords > 0)
+    print_cluster(fMatrix, first, maxLargeSupport, novel, support, inCluster);
+
+  return numRecords;
+}
+
+/*
+  Function: run_parallel, call work(task) for each task from 0 to numTasks-1,
+            using up to numThreads threads.  Tasks are handed out in order as
+            threads become free.
+*/
+void run_parallel(int numTasks, function<void(int)> work) {
+  atomic<int> nextTask(0);
+  auto worker = [&]() {
+    int task;
+    while ((task = nextTask++) < numTasks) work(task);
+  };
+
+  int n = min(numThreads, numTasks);
+  if (n <= 1) { worker(); return; }
+
+  vector<thread> threads;
+  for(int i=0; i < n; i++) threads.push_back(thread(worker));
+  for(auto &t : threads) t.join();
+}
+
+/*
+  Function: load_results, read results file i, sort it, and save it to the
+  temporary file of streams[i].  Called from several threads at once for
+  different files.
+
+  The names go into a string table for just this file, streams[i].names, so
+  the threads don't share anything.  main adds them to stringTable afterwards.
+ */
+void load_results(int i) {
+  RSW_stringPool *names = new RSW_stringPool;
+  vector<RSW_result> fileResults;
+  read_results(linesToSkip, resultsFiles[i], fileResults, *names);
+
+  namePool = names;
+  stable_sort(fileResults.begin(), fileResults.end(), compare_results);
+  namePool = &stringTable;
+
+  int j;
+  maxSupportNum[i] = 0; // initialized to 0
+  for(j=0; j < fileResults.size(); j++) {
+    if (fileResults[j].supportCount > maxSupportNum[i])
+      maxSupportNum[i] = fileResults[j].supportCount;
+  }
+  myNovelCount[i] = myKnownCount[i] = 0; // initialized to 0
+
+  streams[i].count = fileResults.size();
+  streams[i].f = tmpfile();
+  if (streams[i].f == NULL ||
+      fwrite(fileResults.data(), sizeof(RSW_result), fileResults.size(), streams[i].f) != fileResults.size()) {
+    printf("Unable to write temporary file for %s.\n", resultsFiles[i]);
+    exit(1);
+  }
+  rewind(streams[i].f);
+  streams[i].names = names;
+}
 
 int main(int argc, char *argv[]) {
+  int argcAll = argc;     // for printing how it was run
+  char **argvAll = argv;
+  bool cluster = false, binary = false;
+
+  while (argc > 1 && (strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "-b") == 0 ||
+                      (strcmp(argv[1], "-t") == 0 && argc > 2))) {
+    if (argv[1][1] == 'c') {
+      cluster = true;
+      compare_results = compare_cluster_results;
+    }
+    else if (argv[1][1] == 't') {
+      numThreads = atoi(argv[2]);
+      if (numThreads < 1) numThreads = 1;
+      argv++; argc--;
+    }
+    else binary = true;
+    argv++; argc--;
+  }
 
   if (argc < 5) {
-    printf("Usage: ./comp linesToSkip supportPosTolerance outputBasename file1 file2 file3 ...\n"
-       "See splitPairs.cpp file file format of results files.\n");
+    printf("Usage: ./comp [-c] [-b] [-t threads] linesToSkip supportPosTolerance outputBasename file1 file2 file3 ...\n"
+       "See splitPairs.cpp file file format of results files.\n"
+       "  -c  cluster the junctions of all the files, and write a junction by sample matrix\n"
+       "      of supporting reads to outputBasename.junctionMatrix.txt\n"
+       "  -b  also write the rows as a binary junction by sample matrix of supporting reads,\n"
+       "      outputBasename%s (see RSW_binary.h)\n"
+       "  -t  number of results files to read and sort at once, default 1\n", RSW_MATRIX_SUFFIX);
     exit(0);
   }
   
@@ -216,39 +673,37 @@ int main(int argc, char *argv[]) {
   supportPosTolerance = atoi(argv[2]);
 
   // allocate storage for all the results
-  results = new vector<RSW_result *>[numResultsFiles];
+  streams = new RSW_resultStream[numResultsFiles];
   myNovelCount = new int[numResultsFiles];
   myKnownCount = new int[numResultsFiles];
   maxSupportNum = new int[numResultsFiles];
-  int ii[numResultsFiles];
 
-  // read results from each of the results files given as command-line parameter
+  // read results from each of the results files given as command-line parameter,
+  // sort them, and save them to a temporary file.  only numThreads files are in
+  // memory at a time.
+  struct rsf_stats stats;
+  rsf_stats_begin(&stats, "compare", "read_results");
+  linesToSkip = atoi(argv[1]);
+  resultsFiles = argv+4;
+  run_parallel(numResultsFiles, load_results);
+
+  // number the names of all the files in stringTable, in the same order
+  // as reading the files one after the other.
   int i;
-  for(i=4; i < argc; i++) {
-    read_results(atoi(argv[1]), argv[i], results[i-4]);
-
-    sort(results[i-4].begin(), results[i-4].end(), compare_data_results);
-  }
-
-  // put all the results into a single array as well.  We go through that 
-  // array below.
   for(i=0; i < numResultsFiles; i++) {
-    int j;
-    ii[i] = 0;
-    maxSupportNum[i] = 0; // initialized to 0
-    for(j=0; j < results[i].size(); j++) {
-      allResults.push_back(results[i][j]);
-      if (results[i][j]->supportCount > maxSupportNum[i])
-        maxSupportNum[i] = results[i][j]->supportCount;
-    }
-    myNovelCount[i] = myKnownCount[i] = 0; // initialized to 0
-  }
+    RSW_stringPool *names = streams[i].names;
+    for(unsigned int j=0; j < names->size(); j++)
+      streams[i].id.push_back(stringTable.intern(names->str(j)));
+    delete names;
 
-  // sort them, so can match up ones that overlap
-  sort(allResults.begin(), allResults.end(), compare_data_results);
+    stats.bytesIn += rsf_stats_file_size(argv[i+4]);
+    stats.records += streams[i].count;
+  }
+  rsf_stats_end(&stats);
+  rsf_stats_begin(&stats, "compare", "compare");
 
   // open output files...
-  string sResultsName = argv[3]; sResultsName += ".comparedResults.txt";
+  string sResultsName = argv[3]; sResultsName += cluster ? ".junctionMatrix.txt" : ".comparedResults.txt";
   FILE * fResults = fopen(sResultsName.c_str(),"w");
   if (fResults == NULL) {
     printf("Unable to open file %s for writing.\n", sResultsName.c_str());
@@ -264,59 +719,27 @@ int main(int argc, char *argv[]) {
 
   fprintf(fResults,"Comparison run as: ");
   fprintf(fSummary,"Comparison run as: ");
-  for(i=0; i < argc; i++) {
-    fprintf(fResults,"%s ",argv[i]);
-    fprintf(fSummary,"%s ",argv[i]);
+  for(i=0; i < argcAll; i++) {
+    fprintf(fResults,"%s ",argvAll[i]);
+    fprintf(fSummary,"%s ",argvAll[i]);
   }
   fprintf(fResults,"\n");
   fprintf(fSummary,"\n");
 
-  // go through the allResults array.  For each one, we check each of the 
-  // results files to see if it gets printed with that result.
-  int k;
-  for(k=0; k < allResults.size(); k++) {
-    // if already printed this result, continue
-    if (alreadyPrinted.find(allResults[k]) != alreadyPrinted.end()) continue;
-
-    int i_first = -1, i_last = -1;
+  string sMatrixName = argv[3]; sMatrixName += RSW_MATRIX_SUFFIX;
+  if (binary)
+    matrix = new RSW_matrixFile(sMatrixName.c_str(), numResultsFiles);
 
-    fprintf(fResults,"%s\t%s\t", allResults[k]->geneName, allResults[k]->chromosome);
-
-    // check each file and the current spot we are at in that file ...
-    for(i=0; i < numResultsFiles; i++) {
-      bool printIt = false;
-      if (ii[i] < results[i].size() && overlapResult(allResults[k], results[i][ii[i]])) {
-        printIt = true;
-      }
-      if (printIt) {
-        fprintf(fResults,"%li\t%li\t%li--%li\t%s\t",
-            results[i][ii[i]]->supportCount,
-            results[i][ii[i]]->spliceLength,
-            results[i][ii[i]]->minSmallSupport,
-            results[i][ii[i]]->maxLargeSupport,
-            results[i][ii[i]]->novel ? "Novel" : "*");
-        alreadyPrinted.insert(results[i][ii[i]]);
-        // if printed, move one spot further in that file.  note that it will get printed at some point, 
-        //so it's safe to only increment when it gets printed.
-        ii[i]++; 
-        if (i_first == -1) 
-          i_first = i;
-        else 
-          i_last = i;
-      }
-      else {
-        fprintf(fResults,"-\t-\t-\t-\t");
-      }
-    }
+  long int numRecords;
+  if (cluster) {
+    fprintf(fResults,"GeneName\tChromosome\tsplice length\trange of supporting reads\tNovel or not (*)\t# samples");
+    for(i=0; i < numResultsFiles; i++)
+      fprintf(fResults,"\t%s", argv[i+4]);
     fprintf(fResults,"\n");
-
-    // keep track of number of novel/known that are in exactly one of 
-    // the results files.
-    if (i_first != -1 && i_last == -1) {
-      if (allResults[k]->novel) myNovelCount[i_first]++;
-      else myKnownCount[i_first]++;
-    }
+    numRecords = cluster_results(fResults);
   }
+  else
+    numRecords = merge_results(fResults);
 
   printf("Finished running comparison.  Results written to %s.  Summary writen to %s.\n",
       sResultsName.c_str(), sSummaryName.c_str());
@@ -326,12 +749,21 @@ int main(int argc, char *argv[]) {
   printf("file \t#known unique to file \t#novel unique to file\ttotal known+novel in file\tmax support for any read\n");
 
   for(i=0; i < numResultsFiles; i++) {
-    fprintf(fSummary,"%s\t%i\t%i\t%li\t%i\n", argv[i+4], myKnownCount[i], myNovelCount[i], results[i].size(), maxSupportNum[i]);
-    printf("%s\t%i\t%i\t%li\t%i\n", argv[i+4], myKnownCount[i], myNovelCount[i], results[i].size(), maxSupportNum[i]);
+    fprintf(fSummary,"%s\t%i\t%i\t%li\t%i\n", argv[i+4], myKnownCount[i], myNovelCount[i], streams[i].count, maxSupportNum[i]);
+    printf("%s\t%i\t%i\t%li\t%i\n", argv[i+4], myKnownCount[i], myNovelCount[i], streams[i].count, maxSupportNum[i]);
   }
 
+  stats.bytesOut = ftell(fResults) + ftell(fSummary);
+  if (matrix != NULL) {
+    stats.bytesOut += matrix->close(argv+4);
+    printf("Junction matrix written to %s.\n", sMatrixName.c_str());
+  }
+  stats.records = numRecords;
   fclose(fResults);
   fclose(fSummary);
+  for(i=0; i < numResultsFiles; i++)
+    fclose(streams[i].f);
+  rsf_stats_end(&stats);
 
   return 0;
 }
@@ -0,0 +1,117 @@
+/*
+  File:            parallel_sort.h
+
+  Copyright 2015 Jeff Kinne, Yongheng Bai, Brandon Donham.
+  Permission to use for academic, non-profit purposes is granted, in which case this
+  copyright notice should be maintained and original authors acknowledged.
+
+  Version history: Not tracked in this file, see splitPairs.cpp
+
+  Contents:        run_parallel and parallel_sort, used by splitPairs.cpp to
+                   spread work over --threads threads, and by the sort
+                   benchmark in test/bench_sort.cpp.  The program defines
+                   numThreads.
+*/
+
+#ifndef PARALLEL_SORT_H_
+#define PARALLEL_SORT_H_
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+extern int numThreads; // number of threads to use
+
+/*
+  Function: run_parallel, call work(task) for each task from 0 to numTasks-1,
+            using up to numThreads threads.  Tasks are handed out in order as
+            threads become free.
+*/
+void run_parallel(int numTasks, std::function<void(int)> work) {
+  std::atomic<int> nextTask(0);
+  auto worker = [&]() {
+    int task;
+    while ((task = nextTask++) < numTasks) work(task);
+  };
+
+  int n = std::min(numThreads, numTasks);
+  if (n <= 1) { worker(); return; }
+
+  std::vector<std::thread> threads;
+  for(int i=0; i < n; i++) threads.push_back(std::thread(worker));
+  for(auto &t : threads) t.join();
+}
+
+
+/*
+  Function: merge_with_scratch, stable merge of the sorted ranges [lo, mid) and
+            [mid, hi) in place.  The shorter range is first copied to scratch,
+            which must have room for it, and the merge writes back from the
+            other end so nothing is overwritten before it has been read.
+*/
+template<class Iter, class T, class Compare>
+void merge_with_scratch(Iter lo, Iter mid, Iter hi, T *scratch, Compare compare) {
+  if (mid - lo <= hi - mid) {
+    T *left = scratch, *leftEnd = std::copy(lo, mid, scratch);
+    Iter right = mid, out = lo;
+    while (left < leftEnd && right < hi) {
+      if (compare(*right, *left)) *out++ = *right++;
+      else *out++ = *left++;
+    }
+    std::copy(left, leftEnd, out);
+  }
+  else {
+    T *right = scratch, *rightEnd = std::copy(mid, hi, scratch);
+    Iter left = mid, out = hi;
+    while (left > lo && rightEnd > right) {
+      if (compare(*(rightEnd-1), *(left-1))) *--out = *--left;
+      else *--out = *--rightEnd;
+    }
+    std::copy_backward(right, rightEnd, out);
+  }
+}
+
+/*
+  Function: parallel_sort, stable sort of [begin, end) using up to numThreads
+            threads.  Pieces are sorted in parallel, then neighbouring pieces
+            are merged in parallel until one is left.  Gives the same result
+            as stable_sort for any number of threads.  Like stable_sort, the
+            extra memory is for half of the elements: each merge copies only
+            its shorter piece out, and those add up to at most n/2.
+*/
+template<class Iter, class Compare>
+void parallel_sort(Iter begin, Iter end, Compare compare) {
+  typedef typename std::iterator_traits<Iter>::value_type T;
+  long int n = end - begin;
+  if (numThreads <= 1 || n < 65536) { std::stable_sort(begin, end, compare); return; }
+
+  std::vector<long int> bounds; // pieces are [bounds[i], bounds[i+1])
+  for(int p=0; p <= numThreads; p++) bounds.push_back(n * p / numThreads);
+  run_parallel(numThreads, [&](int p) {
+      std::stable_sort(begin + bounds[p], begin + bounds[p+1], compare);
+    });
+
+  std::vector<T> scratch(n / 2);
+  while (bounds.size() > 2) {
+    int pieces = bounds.size() - 1;
+    // merge m uses scratch from offset[m], room for its shorter piece
+    std::vector<long int> offset(pieces / 2 + 1, 0);
+    for(int m=0; m < pieces / 2; m++) {
+      long int lo = bounds[2*m], mid = bounds[2*m+1], hi = bounds[2*m+2];
+      offset[m+1] = offset[m] + std::min(mid - lo, hi - mid);
+    }
+    run_parallel(pieces / 2, [&](int m) {
+        merge_with_scratch(begin + bounds[2*m], begin + bounds[2*m+1], begin + bounds[2*m+2],
+                           scratch.data() + offset[m], compare);
+      });
+    std::vector<long int> merged;
+    for(int i=0; i < pieces; i += 2) merged.push_back(bounds[i]);
+    merged.push_back(n);
+    bounds.swap(merged);
+  }
+}
+
+#endif
@@ -0,0 +1,115 @@
+/*
+  File:            rsf_stats.h
+
+  Copyright 2015 Jeff Kinne, Yongheng Bai, Brandon Donham.
+  Permission to use for academic, non-profit purposes is granted, in which case this
+  copyright notice should be maintained and original authors acknowledged.
+
+  Version history: Not tracked in this file, see the programs that use it
+
+  Contents:        Timing and resource use of each phase of the RSF programs
+                   (sp4, srr, sfc, compare, bowtie-inspect-RSR), written as one
+                   line of JSON per phase so pipeline.sh can put them together
+                   into a report for the run.  Plain C so it can be included by
+                   all of them.
+
+  Usage:
+
+    struct rsf_stats s;
+    rsf_stats_begin(&s, "sp4", "read_data");
+    ... do the phase, adding to s.bytesIn, s.bytesOut, s.records ...
+    rsf_stats_end(&s);
+
+  rsf_stats_end appends a line like
+
+    {"program":"sp4","phase":"read_data","pid":123,"wall_sec":1.500,
+     "cpu_sec":2.900,"peak_rss_kb":40960,"bytes_in":1000,"bytes_out":0,
+     "records":88108,"records_per_sec":58738.7}
+
+  to the file named by the RSF_STATS_FILE environment variable, and does
+  nothing if it is not set.  cpu_sec is for all threads of the process, and
+  peak_rss_kb is the most memory the process has used so far (not just in
+  this phase).  Each line is written with a single write to a file opened
+  for appending, so several programs can write to the same file at once.
+  Program and phase names are written as they are, so should not need any
+  JSON escaping.
+*/
+
+#ifndef RSF_STATS_H_
+#define RSF_STATS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+struct rsf_stats {
+  const char *program;
+  const char *phase;
+  double wallStart, cpuStart;
+  long long bytesIn, bytesOut, records;
+};
+
+static inline double rsf_stats_wall(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static inline double rsf_stats_cpu(void) {
+  struct rusage r;
+  getrusage(RUSAGE_SELF, &r);
+  return r.ru_utime.tv_sec + r.ru_utime.tv_usec * 1e-6 +
+    r.ru_stime.tv_sec + r.ru_stime.tv_usec * 1e-6;
+}
+
+static inline long rsf_stats_peak_rss_kb(void) {
+  struct rusage r;
+  getrusage(RUSAGE_SELF, &r);
+  return r.ru_maxrss; // kilobytes on Linux
+}
+
+/* size of the named file, 0 if it can't be found */
+static inline long long rsf_stats_file_size(const char *filename) {
+  struct stat st;
+  return stat(filename, &st) == 0 ? (long long) st.st_size : 0;
+}
+
+static inline void rsf_stats_begin(struct rsf_stats *s, const char *program, const char *phase) {
+  s->program = program;
+  s->phase = phase;
+  s->bytesIn = s->bytesOut = s->records = 0;
+  s->wallStart = rsf_stats_wall();
+  s->cpuStart = rsf_stats_cpu();
+}
+
+static inline void rsf_stats_end(struct rsf_stats *s) {
+  const char *filename = getenv("RSF_STATS_FILE");
+  if (filename == NULL || filename[0] == '\0') return;
+
+  double wall = rsf_stats_wall() - s->wallStart;
+  double cpu = rsf_stats_cpu() - s->cpuStart;
+  char line[1024];
+  int len = snprintf(line, sizeof(line),
+                     "{\"program\":\"%s\",\"phase\":\"%s\",\"pid\":%ld,"
+                     "\"wall_sec\":%.3f,\"cpu_sec\":%.3f,\"peak_rss_kb\":%ld,"
+                     "\"bytes_in\":%lld,\"bytes_out\":%lld,\"records\":%lld,"
+                     "\"records_per_sec\":%.1f}\n",
+                     s->program, s->phase, (long) getpid(),
+                     wall, cpu, rsf_stats_peak_rss_kb(),
+                     s->bytesIn, s->bytesOut, s->records,
+                     wall > 0 ? s->records / wall : 0.0);
+  if (len <= 0 || len >= (int) sizeof(line)) return;
+
+  int fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0) return;
+  if (write(fd, line, len) != len)
+    fprintf(stderr, "Warning: could not write statistics to %s\n", filename);
+  close(fd);
+}
+
+#endif
@@ -10,9 +10,9 @@
                unaligned read resulted from a splice.  Also, determine which
                matched pairs support each other (resulted from the same splice junction).
 
-  To compile: g++ splitPairs.cpp -o sp -O4 -std=c++11
+  To compile: g++ splitPairs.cpp -o sp -O4 -std=c++11 -pthread -lz
 
-  To run:     ./sp options.txt
+  To run:     ./sp options.txt [--threads N] [--memory MB] [--temp-dir DIR]
 
               Where options.txt is an options file.  If the program is run
               with no command-line arguments it by default processes
@@ -21,8 +21,92 @@
               prints which files output is written to.  See readOptionsFromFile
               function for the order of the parameters in the options file.
 
+              --memory MB limits the memory used for the read data (the
+              records from the split1stcolumn file) while it is sorted: runs
+              of records and the space to sort them fit in MB, and the
+              sorted data is read from a memory-mapped file.  It does not
+              cover the string table (one copy of each read id, chromosome
+              and gene name), the junctions found (data_splice), or the
+              refFlat and boundary data, which are all kept in memory.
+
 Modification history...  
 
+10/17/2026 - RSW_stringPool stops with an error at 2^31 strings, since the
+             packed sort keys need chromosome ids below 2^31.
+10/17/2026 - merge_runs merges at most 256 runs at once (fewer with a small
+             --memory), in passes, so the open files and the read buffers
+             stay within limits however many runs there are.
+10/17/2026 - index data and data_splice with size_t everywhere after the sort
+             (find_matched_pairs, compute_support, checkHalf, the parts
+             and per-chromosome ranges, the output loop), since with
+             --memory there can be more than 2^31 records.  The parts are
+             made by part_starts in RSW.h, checked by test/part_starts_test.cpp.
+10/17/2026 - --memory MB now covers sorting too: runs are 2/3 of MB, leaving
+             room for parallel_sort's scratch, and the buffers for merging
+             the runs are sized from MB.  The header comment lists what
+             MB does not cover.
+10/17/2026 - parallel_sort merges pieces in place through one scratch buffer
+             of half the elements, instead of into a second copy of the
+             whole array, so it needs no more memory than stable_sort.
+10/16/2026 - checkHalf returns 0 for a half at the right position that fails
+             the strand/other half test, so it is no longer counted.  The
+             earlier code fell off the end of the function here and the
+             optimized builds counted it.  Changes '# supporting halves',
+             '# supporting total' and which junctions have enough support
+             (see CHANGES IN RESULTS in README.md).
+10/16/2026 - write the time, cpu time, peak memory and number of records of
+             each phase as JSON to $RSF_STATS_FILE (see rsf_stats.h), for
+             pipeline.sh's run report.  read_data returns the number of lines.
+10/16/2026 - read_data reads .gz files with zlib, in large blocks parsed in
+             place like the memory-mapped files, instead of line by line
+             from a gunzip -c pipe.
+10/16/2026 - read_data also reads bowtie's output directly, splitting the read
+             name into id, side, length and total length the way
+             split_columns.c does, so the sfc step can be skipped.
+10/16/2026 - read_data also reads the binary columnar format written by
+             sfc -b (RSW_binary.h), from the memory-mapped file without
+             parsing any text.
+10/16/2026 - sort the read data and junctions with parallel_sort (stable, so the
+             results no longer depend on std::sort's order of ties), and
+             compare packed 64 bit keys in the comparators.
+10/16/2026 - add --memory MB and --temp-dir DIR to sort the read data externally:
+             sorted runs of at most MB of records are written to DIR and
+             merged, and the merged file is memory-mapped (see RSW_array).
+             For inputs larger than memory.
+10/16/2026 - remove the data_halves hash map (and the id+side strings that were
+             its keys).  The min/max length of each half is computed in one
+             pass over the data once sorted by id, and each record stores the
+             max length of the other half (otherHalfMaxLength).
+10/16/2026 - RSW records are packed into 24 bytes: 32-bit position, and the
+             lengths, side and direction in bit fields (side, direction and
+             splitPos are now methods).  Unused count/hash/sequence removed.
+10/16/2026 - replace the unordered_set<string> string table with RSW_stringPool
+             (see RSW.h), which packs the strings into large blocks and gives
+             each a 32-bit id.  Records store these ids instead of pointers.
+             printStats prints the memory used by the string table.
+10/16/2026 - read_data memory-maps plain input files and parses the fields in
+             place; only the id and chromosome are copied (into the string
+             table).  Prints lines/sec for reading the data.
+10/16/2026 - compute supporting reads for each chromosome separately, in parallel
+             with --threads.  checkHalf now stops at the end of the
+             chromosome's data, and returns 1 (what the optimized builds did
+             when it fell off the end of the function) for a half at the
+             right position that fails the strand/other half test.
+10/16/2026 - add --threads N.  Matched pairs are found in parallel - the data
+             sorted by id is split at read id boundaries and the splices
+             from each part are appended in order, so output is the same as
+             with one thread.  (Replaces the openmp attempt noted below.)
+10/16/2026 - index the intron boundary file by (chromosome, intron length) with
+             sorted position lists, so checking if a junction is novel is a
+             binary search.  The check now also requires the chromosome to
+             match, which the old scan did not.
+10/16/2026 - look up the gene a junction is in with a per-chromosome index into
+             the sorted data_known (binary search on start position, plus the
+             running max of end positions) instead of scanning all of refFlat.
+10/16/2026 - check for duplicate splices from the same read with a hash set keyed
+             by (id, chromosome, positionSmaller, positionLarger) rather than
+             scanning all of data_splice for each candidate junction.
+
 3/17/2016   - update the algorithm for selecting supporting reads to be more 
              memory-efficient.  This includes writing to the results files as 
       the program runs.  Also, update the .splitPairs format to take
@@ -65,12 +149,25 @@ Modification history...
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <queue>
 #include <time.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
 //#include <omp.h>
 using namespace std;
 
 #include "RSW.h"
+#include "parallel_sort.h"
+#include "RSW_binary.h"
+#include "rsf_stats.h"
 
 
 // parameters input from options file
@@ -92,174 +189,685 @@ char buff[MAX_STR_LEN];
 char options[MAX_STR_LEN];
 
 time_t beginTime, endTime;  // for keeping track of running time of program
+rsf_stats phaseStats, totalStats; // for $RSF_STATS_FILE, see rsf_stats.h
 
 // string table is used to reduce memory usage of program.  for any string
-// we need we store it in the string table and then only use the pointer to the
-// string any time we need it.  So two records from the input file with the same
-// read id won't take up twice as much memory.  See reading of data file for
+// we need we store it in the string table and then only use the 32-bit id of
+// the string any time we need it.  So two records from the input file with the same
+// read id won't take up twice as much memory.  See RSW_stringPool in RSW.h for
 // how this works.
-unordered_set<string> stringTable;
+RSW_stringPool stringTable;
 
 // used in printing of results to avoid printing multiple junction sites
 // multiple times
 //unordered_set<const char *> readIdsReported;
 
 // data read into the program
-vector<struct RSW> data; // from input file of alignments of pieces of unaligned reads
+/*
+  Array of RSW records.  Normally the records are held in memory, but when
+  sorting externally (--memory) the sorted records are in a file on disk that
+  is memory-mapped, so the operating system only keeps the parts being used
+  in memory.
+*/
+class RSW_array {
+ public:
+  RSW_array() : records(NULL), n(0), mappedBytes(0) {}
+
+  RSW & operator[](size_t i) { return records[i]; }
+  size_t size() const { return n; }
+  RSW * begin() { return records; }
+  RSW * end() { return records + n; }
+
+  void push_back(RSW const &r) {
+    mem.push_back(r);
+    records = mem.data(); n = mem.size();
+  }
+
+  // replace the contents with the records in the given file.  the file is
+  // removed, it stays readable until clear() is called.
+  void map(const char *filename) {
+    clear();
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {printf("Error reading from file %s\n", filename); exit(0); }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {printf("Error reading from file %s\n", filename); exit(0); }
+    if (st.st_size > 0) {
+      void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (m == MAP_FAILED) {printf("Error mapping file %s into memory\n", filename); exit(0); }
+      madvise(m, st.st_size, MADV_SEQUENTIAL);
+      records = (RSW *) m;
+      n = st.st_size / sizeof(RSW);
+      mappedBytes = st.st_size;
+    }
+    close(fd);
+    unlink(filename);
+  }
+
+  void clear() {
+    if (mappedBytes > 0) munmap(records, mappedBytes);
+    vector<RSW>().swap(mem);
+    records = NULL; n = 0; mappedBytes = 0;
+  }
+
+ private:
+  vector<RSW> mem;
+  RSW *records;
+  size_t n;
+  size_t mappedBytes;
+};
+
+RSW_array data; // from input file of alignments of pieces of unaligned reads
 vector<struct RSW_Known> data_known; // from refFlat
 vector<struct RSW_Boundaries> data_boundaries; // from refFlat intron/extron boundaries
 
-unordered_map<const char *, RSW_half_data> data_halves; // stores information about max/min length seen from each half of an id
-string halfStatsString=""; // computed once all data is read in, then printed later.
+/*
+  Key for looking up intron boundaries - boundaries on the same chromosome
+  with the same intron length.
+*/
+class RSW_boundaryKey {
+ public:
+  unsigned int chromosome;
+  long int length;
+
+  bool operator==(RSW_boundaryKey const &other) const {
+    return chromosome == other.chromosome && length == other.length;
+  }
+};
+
+class RSW_boundaryKeyHash {
+ public:
+  size_t operator()(RSW_boundaryKey const &k) const {
+    return (size_t) k.chromosome * 31 + (size_t) k.length;
+  }
+};
+
+// (position1, position2) of each boundary, sorted, for each chromosome and length.
+// built by read_boundaries, used by is_novel.
+unordered_map<RSW_boundaryKey, vector<pair<long int, long int> >, RSW_boundaryKeyHash> boundaryIndex;
+
+// index for looking up genes in data_known, see index_knownGene
+unordered_map<unsigned int, pair<int,int> > knownChromRange; // chromosome -> [first,last+1) in data_known
+vector<long int> knownMaxEnd; // largest position2 of data_known from start of chromosome up to this index
+
+// statistics of the max/min length seen from each half (id and side), see set_half_lengths
+long int halfCount = 0, halfMinTotal = 0, halfMaxTotal = 0;
+int halfMinMax = -1, halfMinMin = -1, halfMaxMax = -1, halfMaxMin = -1;
+string halfStatsString=""; // computed once all data is read in and sorted, then printed later.
 
 const char unfound_string[100] = "UNFOUND_";   // gene name of any junction outside of genes
+unsigned int unfound_id; // unfound_string in the string table
 
 vector<RSW_splice *> data_splice; // used to store possible jucntions, see RSW.h for RSW_splice definition
 
-int numDifferentReads; // counter...
+/*
+  Key used to check if we already have a given splice from a given read.
+  Strings are in the string table, so comparing the ids is enough.
+*/
+class RSW_spliceKey {
+ public:
+  unsigned int id;
+  unsigned int chromosome;
+  long int positionSmaller;
+  long int positionLarger;
+
+  bool operator==(RSW_spliceKey const &other) const {
+    return id == other.id && chromosome == other.chromosome &&
+      positionSmaller == other.positionSmaller && positionLarger == other.positionLarger;
+  }
+};
+
+class RSW_spliceKeyHash {
+ public:
+  size_t operator()(RSW_spliceKey const &k) const {
+    size_t h = (size_t) k.id;
+    h = h * 31 + (size_t) k.chromosome;
+    h = h * 31 + (size_t) k.positionSmaller;
+    h = h * 31 + (size_t) k.positionLarger;
+    return h;
+  }
+};
 
-// function not currently used
-int compute_hash(RSW *d) {
-  int h = 1, i;
-  for(i=0; d->id[i] != '\0'; i++) h = h * d->id[i] % SHRT_MAX;
-  for(i=0; d->chromosome[i] != '\0'; i++) h = h * d->chromosome[i] % SHRT_MAX;
-  h = h * d->direction % SHRT_MAX;
-  return h;
-}
+long int numDifferentReads; // counter...
 
+int numThreads = 1; // number of threads to use, from --threads on the command line
+
+// external sorting, used if --memory is given on the command line.  records are
+// collected into runBuffer until it holds memoryBudget MB, then sorted and written
+// to a run file in tempDir.  the runs are merged into one sorted file.
+long int memoryBudget = 0; // in MB, 0 means keep all data in memory
+const char *tempDir = ".";
+vector<RSW> runBuffer;
+vector<string> runFiles;
+int numTempFiles = 0;
 
 char sLine[MAX_LINE+1];
 char temp[MAX_LINE+1];
 
 /*
-  Function: read_data, read in data file into data vector
+  Function: set_half_lengths, for the records of one read id, find the min and
+            max length of the pieces from each side (L and R).  Each record gets
+            the max length from the other side, and the min/max of each side are
+            added into the half statistics.
 
-  Parameters: filename - file to open and read
+  Parameters: begin, end - the records of the read id, begin[0] .. end[-1].
+*/
+void set_half_lengths(RSW *begin, RSW *end) {
+  RSW_half_data half[2]; // left, right
+  half[0].minLength = half[1].minLength = -1;
+  half[0].maxLength = half[1].maxLength = 0;
+  for(RSW *r=begin; r < end; r++) {
+    RSW_half_data &h = half[r->rightSide];
+    if (h.minLength == -1 || r->length < h.minLength) h.minLength = r->length;
+    if (r->length > h.maxLength) h.maxLength = r->length;
+  }
+  for(RSW *r=begin; r < end; r++) {
+    r->otherHalfMaxLength = half[1 - r->rightSide].maxLength;
+  }
+
+  for(int side=0; side < 2; side++) {
+    if (half[side].minLength == -1) continue; // no pieces from this side
+    int min = half[side].minLength, max = half[side].maxLength;
+    halfCount++;
+    halfMinTotal += min;  halfMaxTotal += max;
+    if (halfMinMax == -1 || min > halfMinMax) halfMinMax = min;
+    if (halfMinMin == -1 || min < halfMinMin) halfMinMin = min;
+    if (halfMaxMax == -1 || max > halfMaxMax) halfMaxMax = max;
+    if (halfMaxMin == -1 || max < halfMaxMin) halfMaxMin = max;
+  }
+}
 
-  Note: if file is .gz or .lrz then attempt to unzip before reading.  This will
-  only work if gunzip and/or lrunzip can be run from the current directory.
+/*
+  Function: compute_half_data, call set_half_lengths for each read id.  data
+            must be sorted with compare_dataById.
 */
-void read_data(const char *filename) {
-  // open file for reading (from pipe if trying to unzip)
-  FILE *f;
-  int len = strlen(filename);
-  if (len > 3 && strcmp(filename+len-3,".gz")==0) {
-    sprintf(temp,"gunzip -c %s", filename);
-    f = popen(temp, "r");
+void compute_half_data() {
+  size_t begin = 0;
+  for(size_t i=1; i <= data.size(); i++) {
+    if (i == data.size() || data[i].id != data[begin].id) {
+      set_half_lengths(data.begin() + begin, data.begin() + i);
+      begin = i;
+    }
   }
-  else if (len > 4 && strcmp(filename+len-4,".lrz")==0) {
-    sprintf(temp,"cat %s | ./lrunzip", filename);
-    f = popen(temp, "r");
+}
+
+
+/*
+  Function: temp_file_name, make a new file name in tempDir for external sorting.
+*/
+string temp_file_name(const char *what) {
+  char name[MAX_STR_LEN];
+  snprintf(name, MAX_STR_LEN, "%s/sp4.%i.%s.%i", tempDir, (int) getpid(), what, numTempFiles++);
+  return name;
+}
+
+/*
+  Function: write_run, sort the records in runBuffer and write them to a new
+            run file, then empty runBuffer.
+*/
+void write_run(bool (*compare)(RSW const &, RSW const &)) {
+  if (runBuffer.size() == 0) return;
+  parallel_sort(runBuffer.begin(), runBuffer.end(), compare);
+
+  string name = temp_file_name("run");
+  FILE *f = fopen(name.c_str(), "w");
+  if (f == NULL) { printf("Error opening file %s for writing.\n", name.c_str()); exit(0); }
+  if (fwrite(runBuffer.data(), sizeof(RSW), runBuffer.size(), f) != runBuffer.size()) {
+    printf("Error writing to file %s.\n", name.c_str()); exit(0);
   }
-  else f = fopen(filename, "r");
-  if (f == NULL) {printf("Error reading from file %s\n", filename); exit(0); }
+  fclose(f);
 
-  // read data file one line at a time.
-  int result=1;
-  while (result > 0) {
-    int i; char dir;
-    RSW *r = new RSW;
-    result = get_line(f, sLine, MAX_LINE);
-    if (result < 0) {
-      printf("Error reading data file %s, line exceeded %i characters.\n", filename, MAX_LINE);
-      delete r;
-      break;
+  runFiles.push_back(name);
+  runBuffer.clear();
+}
+
+/*
+  Function: run_records, number of records in a run when sorting externally.
+            Sorting a run needs room for half as many records again (see
+            parallel_sort), so the run itself gets 2/3 of memoryBudget.
+*/
+size_t run_records() {
+  return max((size_t) 1, (size_t) memoryBudget * 1024 * 1024 / 3 * 2 / sizeof(RSW));
+}
+
+/*
+  Function: save_record, add a record read from the data file, either to data or
+            if sorting externally to runBuffer (writing a run if it is full).
+*/
+void save_record(RSW const &r) {
+  if (memoryBudget <= 0) {
+    data.push_back(r);        // save into vector
+    return;
+  }
+  if (runBuffer.capacity() == 0)
+    runBuffer.reserve(run_records());
+  runBuffer.push_back(r);
+  if (runBuffer.size() == runBuffer.capacity())
+    write_run(compare_dataById);
+}
+
+/*
+  Used while merging run files - the next record from one run.
+*/
+class RSW_runCursor {
+ public:
+  FILE *f;
+  RSW current;
+  bool done;
+
+  void next() { done = fread(&current, sizeof(RSW), 1, f) != 1; }
+};
+
+/*
+  At most this many run files are merged at once, so the number of open
+  files stays well under the usual limit of 1024.  Each gets a read buffer
+  of at least MIN_MERGE_BUFFER, so with a small memoryBudget fewer are
+  merged at once.  When there are more runs they are merged in passes.
+*/
+#define MAX_MERGE_RUNS 256
+#define MIN_MERGE_BUFFER (64 * 1024)
+
+/*
+  Function: merge_files, merge sorted run files into one new sorted file.  The
+            run files are removed.
+
+  Parameters: files - the runs, ties go to the earlier file.  compare - order
+              the runs were sorted in.  byId - true if sorted with
+              compare_dataById and this is the last pass, in which case
+              set_half_lengths is done for each read id as the records are
+              merged.  what - for the name of the new file.
+
+  Return: name of the new file.
+*/
+string merge_files(const vector<string> &files, bool (*compare)(RSW const &, RSW const &),
+                   bool byId, const char *what) {
+  // the read buffers and the output buffer share memoryBudget
+  size_t bufferSize = (size_t) memoryBudget * 1024 * 1024 / (files.size() + 1);
+  bufferSize = min((size_t) 1 << 20, max((size_t) MIN_MERGE_BUFFER, bufferSize));
+
+  vector<RSW_runCursor> runs(files.size());
+  for(size_t i=0; i < runs.size(); i++) {
+    runs[i].f = fopen(files[i].c_str(), "r");
+    if (runs[i].f == NULL) {printf("Error reading from file %s\n", files[i].c_str()); exit(0); }
+    setvbuf(runs[i].f, NULL, _IOFBF, bufferSize);
+    runs[i].next();
+  }
+
+  // heap of runs that still have records, smallest record on top.  ties go to
+  // the earlier run, so the result does not depend on the heap.
+  auto after = [&](int a, int b) {
+    if (compare(runs[b].current, runs[a].current)) return true;
+    if (compare(runs[a].current, runs[b].current)) return false;
+    return a > b;
+  };
+  priority_queue<int, vector<int>, decltype(after)> heap(after);
+  for(int i=0; i < runs.size(); i++)
+    if (! runs[i].done) heap.push(i);
+
+  string name = temp_file_name(what);
+  FILE *out = fopen(name.c_str(), "w");
+  if (out == NULL) { printf("Error opening file %s for writing.\n", name.c_str()); exit(0); }
+  setvbuf(out, NULL, _IOFBF, bufferSize);
+
+  vector<RSW> group; // records of the current read id, if byId
+  while (! heap.empty() || group.size() > 0) {
+    if (byId && group.size() > 0 &&
+        (heap.empty() || runs[heap.top()].current.id != group[0].id)) {
+      set_half_lengths(group.data(), group.data() + group.size());
+      fwrite(group.data(), sizeof(RSW), group.size(), out);
+      group.clear();
+      continue;
     }
 
-    // break line into fields, separated by tab
-    char *tempA = strtok(sLine, "\t");
-    i=0;
-    while (tempA != NULL) {
-      string temp = tempA; temp.shrink_to_fit();
-      pair<unordered_set<string>::iterator,bool> result;
-      switch (i) {
-      case 0: // id of read
-        // put into string table and store pointer to string.  note
-        // that insert just returns a pointer if the string already was in the string table.
-        result = stringTable.insert(temp);
-        r->id = (result.first)->c_str();
-        break;
-      case 1: // side
-        r->side = temp[0];
-        break;
-      case 2: // length of piece
-        r->length = atoi(temp.c_str());
-        break;
-      case 3: // total length of read this piece is in
-        r->totalReadLength = atoi(temp.c_str());
-        break;
-      case 4: // direction
-        r->direction = temp[0];
-        break;
-      case 5: // chromosome
-        result = stringTable.insert(temp);
-        r->chromosome = (result.first)->c_str();
-        break;
-      case 6: // position
-        r->position = atol(temp.c_str());
-        break;
-      case 9: // count, unused currently
-        r->count = atoi(temp.c_str());
-        break;
-      }
-      i++;
-      tempA = strtok(NULL,"\t");
-      if (tempA == NULL) break;
+    int i = heap.top(); heap.pop();
+    if (byId) group.push_back(runs[i].current);
+    else fwrite(&runs[i].current, sizeof(RSW), 1, out);
+    runs[i].next();
+    if (! runs[i].done) heap.push(i);
+  }
+
+  if (fclose(out) != 0) { printf("Error writing to file %s.\n", name.c_str()); exit(0); }
+  for(size_t i=0; i < runs.size(); i++) {
+    fclose(runs[i].f);
+    unlink(files[i].c_str());
+  }
+  return name;
+}
+
+/*
+  Function: merge_runs, merge the sorted run files into one sorted file, and
+            then use that file as data.  The run files are removed.
+
+  Parameters: compare - order the runs were sorted in.  byId - true if sorted
+              with compare_dataById, in which case set_half_lengths is done for
+              each read id as the records are merged.
+*/
+void merge_runs(bool (*compare)(RSW const &, RSW const &), bool byId) {
+  size_t budget = (size_t) memoryBudget * 1024 * 1024;
+  size_t fanIn = min((size_t) MAX_MERGE_RUNS, max((size_t) 2, budget / MIN_MERGE_BUFFER - 1));
+
+  // merge groups of fanIn runs into longer runs until one pass is left.  the
+  // groups are of runs next to each other, so ties stay in the order of the runs.
+  while (runFiles.size() > fanIn) {
+    vector<string> merged;
+    for(size_t i=0; i < runFiles.size(); i += fanIn) {
+      vector<string> group(runFiles.begin() + i, runFiles.begin() + min(runFiles.size(), i + fanIn));
+      if (group.size() == 1) merged.push_back(group[0]);
+      else merged.push_back(merge_files(group, compare, false, "run"));
     }
-    if (i < 10) {
-      delete r; 
-      break;
+    runFiles.swap(merged);
+  }
+
+  string name = merge_files(runFiles, compare, byId, "sorted");
+  runFiles.clear();
+  data.map(name.c_str());
+}
+
+/*
+  Function: external_sort_data, sort data using run files on disk, holding at
+            most memoryBudget MB of records (and sort space) in memory at a time.
+*/
+void external_sort_data(bool (*compare)(RSW const &, RSW const &)) {
+  size_t runRecords = run_records();
+  runBuffer.reserve(runRecords);
+  for(size_t i=0; i < data.size(); i += runRecords) {
+    size_t end = min(data.size(), i + runRecords);
+    runBuffer.assign(data.begin() + i, data.begin() + end);
+    write_run(compare);
+  }
+  vector<RSW>().swap(runBuffer);
+  data.clear();
+  merge_runs(compare, false);
+}
+
+/*
+  Function: parse_long, parse a (possibly negative) integer from s up to end,
+            stopping at the first character that is not a digit.
+*/
+long int parse_long(const char *s, const char *end) {
+  bool negative = false;
+  if (s < end && *s == '-') { negative = true; s++; }
+  long int x = 0;
+  for(; s < end && *s >= '0' && *s <= '9'; s++)
+    x = x*10 + (*s - '0');
+  return negative ? -x : x;
+}
+
+/*
+  Function: intern, put a string into the string table and return its id.
+*/
+unsigned int intern(const char *s, const char *end) {
+  return stringTable.intern(s, end-s);
+}
+
+/*
+  Function: parse_bowtie_name, split the read name from raw bowtie output,
+            like ID-R-68-130/2, into the id (ID/2), side, length of piece
+            and total length of read.  This is what split_columns.c does by
+            rewriting the file; doing it here means sp4 can read the
+            .bowtie.txt file directly.
+
+  Return: id in the string table.
+*/
+unsigned int parse_bowtie_name(const char *name, const char *end, const char *line, const char *lineEnd,
+                               bool &rightSide, long int &length, long int &totalReadLength) {
+  // a /1 or /2 at the end is moved to the end of the id
+  bool paired = end - name >= 2 && end[-2] == '/' && (end[-1] == '1' || end[-1] == '2');
+  const char *nameEnd = paired ? end-2 : end;
+
+  // the last three '-' separate the side, length, and total length
+  const char *dash[3];
+  int numDashes = 0;
+  for(const char *c = nameEnd-1; c >= name && numDashes < 3; c--)
+    if (*c == '-') dash[numDashes++] = c;
+  if (numDashes < 3) {
+    printf("Error, read name does not end in -side-length-totalLength in data file line: %.*s\n",
+           (int) (lineEnd-line), line);
+    exit(0);
+  }
+
+  rightSide = dash[2][1] == 'R';
+  length = parse_long(dash[1]+1, dash[0]);
+  totalReadLength = parse_long(dash[0]+1, nameEnd);
+
+  if (! paired) return intern(name, dash[2]);
+  char id[MAX_STR_LEN];
+  int idLen = dash[2] - name;
+  if (idLen + 2 >= MAX_STR_LEN) {
+    printf("Error, read name too long in data file line: %.*s\n", (int) (lineEnd-line), line);
+    exit(0);
+  }
+  memcpy(id, name, idLen);
+  memcpy(id + idLen, end-2, 2);
+  return stringTable.intern(id, idLen + 2);
+}
+
+/*
+  Function: add_data_line, parse one line of the data file into an RSW record
+            and save it into the data vector.  The line can either be from
+            the .split1stcolumn file made by split_columns.c, or directly
+            from bowtie's output (the second field is then the direction
+            rather than the side).
+
+  Parameters: line - start of line, end - end of line (not including the newline).
+              The line is not modified, so it can point into a memory-mapped file.
+
+  Return: false if the line does not have enough fields, true otherwise.
+*/
+bool add_data_line(const char *line, const char *end) {
+  // find the tab separated fields, only the first 10 are used.
+  const char *field[11];
+  int numFields = 0;
+  field[numFields++] = line;
+  for(const char *c=line; numFields < 11; c++) {
+    c = (const char *) memchr(c, '\t', end-c);
+    if (c == NULL) break;
+    field[numFields++] = c+1;
+  }
+
+  RSW r;
+  long int length, totalReadLength, position;
+  if (numFields >= 2 && (*field[1] == '+' || *field[1] == '-')) {
+    // raw bowtie output: read name, direction, chromosome, position, ...
+    if (numFields < 4) return false;
+    if (numFields < 11) field[numFields] = end+1;
+    bool rightSide;
+    r.id = parse_bowtie_name(field[0], field[1]-1, line, end, rightSide, length, totalReadLength);
+    r.rightSide = rightSide;
+    r.minusStrand = *field[1] == '-';
+    r.chromosome = intern(field[2], field[3]-1);
+    position = parse_long(field[3], field[4]-1);
+  }
+  else {
+    if (numFields < 10) return false;
+    if (numFields == 10) field[numFields] = end+1;
+
+    // only the id and chromosome are copied, into the string table.  note
+    // that intern just returns the id if the string already was in the string table.
+    r.id = intern(field[0], field[1]-1);                   // id of read
+    r.rightSide = *field[1] == 'R';                        // side
+    length = parse_long(field[2], field[3]-1);             // length of piece
+    totalReadLength = parse_long(field[3], field[4]-1);    // total length of read this piece is in
+    r.minusStrand = *field[4] == '-';                      // direction
+    r.chromosome = intern(field[5], field[6]-1);           // chromosome
+    position = parse_long(field[6], field[7]-1);           // position
+  }
+
+  // make sure the values fit into the packed record
+  if (length < 0 || length >= (1 << 15) || totalReadLength < 0 || totalReadLength >= (1 << 15) ||
+      position < 0 || position > UINT_MAX) {
+    printf("Error, value out of range in data file line: %.*s\n", (int) (end-line), line);
+    exit(0);
+  }
+  r.length = length;
+  r.totalReadLength = totalReadLength;
+  r.position = position;
+
+  r.otherHalfMaxLength = 0; // set by set_half_lengths once data is sorted
+
+  save_record(r);
+  //if (data.size() >= 15000000) return false; // cut off early, for debugging to prevent program from running for too long.
+  return true;
+}
+
+/*
+  Function: add_binary_data, save the records from a binary file made by
+            sfc -b (format in RSW_binary.h) that has been mapped into memory.
+
+  Return: the number of records.
+*/
+long int add_binary_data(const char *map, size_t size, const char *filename) {
+  const RSW_binaryHeader *h = (const RSW_binaryHeader *) map;
+  if (size < sizeof(RSW_binaryHeader) || RSW_BINARY_FILE_SIZE(h) != size) {
+    printf("Error, binary data file %s is the wrong size.\n", filename); exit(0);
+  }
+  long int n = h->numRecords;
+  const uint32_t *id = (const uint32_t *) (map + sizeof(RSW_binaryHeader));
+  const uint32_t *chromosome = id + n;
+  const uint32_t *position = chromosome + n;
+  const uint16_t *length = (const uint16_t *) (position + n);
+  const uint16_t *totalReadLength = length + n;
+  const uint8_t *flags = (const uint8_t *) (totalReadLength + n);
+  const char *strings = (const char *) (flags + n);
+
+  // string numbers in the file -> ids in the string table
+  vector<unsigned int> stringId(h->numStrings);
+  const char *s = strings;
+  for(long int i=0; i < h->numStrings; i++) {
+    size_t len = strnlen(s, strings + h->stringBytes - s);
+    stringId[i] = stringTable.intern(s, len);
+    s += len + 1;
+  }
+
+  for(long int i=0; i < n; i++) {
+    if (id[i] >= h->numStrings || chromosome[i] >= h->numStrings ||
+        length[i] >= (1 << 15) || totalReadLength[i] >= (1 << 15)) {
+      printf("Error, value out of range in binary data file %s, record %li.\n", filename, i); exit(0);
     }
+    RSW r;
+    r.id = stringId[id[i]];
+    r.chromosome = stringId[chromosome[i]];
+    r.position = position[i];
+    r.length = length[i];
+    r.totalReadLength = totalReadLength[i];
+    r.rightSide = (flags[i] & RSW_BINARY_RIGHT_SIDE) != 0;
+    r.minusStrand = (flags[i] & RSW_BINARY_MINUS_STRAND) != 0;
+    r.otherHalfMaxLength = 0; // set by set_half_lengths once data is sorted
+    save_record(r);
+  }
+  return n;
+}
 
-    r->hash = compute_hash(r); // not currently used
+/*
+  Function: read_data, read in data file into data vector
 
-    // update RSW_half information ...
+  Parameters: filename - file to open and read
 
-    // look to see if we've seen this id and half before.
-    // id is pointer to string with id + which side.
-    pair<unordered_set<string>::iterator,bool> res;
-    string temp;
-    temp = r->id; temp += r->side; temp.shrink_to_fit();
-    res = stringTable.insert(temp);
-    const char * key = (res.first)->c_str();
-    
-    temp = r->id; temp += toupper(r->side) == 'L' ? 'R' : 'L';
-    res = stringTable.insert(temp);
-    const char * otherKey = (res.first)->c_str();
-    
-    auto h_find = data_halves.find(key);
-    
-    if (h_find == data_halves.end()) { // if new, insert
-      RSW_half_data hd; 
-      hd.minLength = hd.maxLength = r->length;
-      data_halves.insert({key, hd});
+  Return: number of lines (records) read
+
+  Note: if file is .gz it is uncompressed with zlib a block at a time, and the
+  lines parsed in the block.  If .lrz then attempt to unzip before reading, this
+  will only work if lrunzip can be run from the current directory.
+  Otherwise the file is memory-mapped and parsed in place, or if it is in the
+  binary format from sfc -b its columns are read in place.
+*/
+long int read_data(const char *filename) {
+  auto startTime = chrono::steady_clock::now();
+  long int numLines = 0;
+
+  // open file for reading (from pipe if trying to unzip)
+  FILE *f = NULL;
+  int len = strlen(filename);
+  if (len > 4 && strcmp(filename+len-4,".lrz")==0) {
+    sprintf(temp,"cat %s | ./lrunzip", filename);
+    f = popen(temp, "r");
+  }
+
+  if (len > 3 && strcmp(filename+len-3,".gz")==0) {
+    gzFile z = gzopen(filename, "r");
+    if (z == NULL) {printf("Error reading from file %s\n", filename); exit(0); }
+    gzbuffer(z, 1 << 20);
+
+    // lines are parsed in the block they are uncompressed into; a partial
+    // line at the end of the block is moved to the front for the next read.
+    vector<char> block(1 << 24);
+    size_t carried = 0;
+    bool done = false;
+    while (! done) {
+      int n = gzread(z, block.data() + carried, block.size() - carried);
+      if (n < 0) {
+        int err;
+        printf("Error reading from file %s: %s\n", filename, gzerror(z, &err));
+        exit(0);
+      }
+      const char *line = block.data(), *blockEnd = block.data() + carried + n;
+      while (line < blockEnd) {
+        const char *end = (const char *) memchr(line, '\n', blockEnd-line);
+        if (end == NULL) {
+          if (n > 0) break;
+          end = blockEnd; // last line, no newline
+        }
+        if (! add_data_line(line, end)) { done = true; break; }
+        numLines++;
+        line = end+1;
+      }
+      if (n == 0) break;
+      carried = line < blockEnd ? blockEnd - line : 0;
+      memmove(block.data(), line, carried);
+      if (carried == block.size()) block.resize(2 * block.size());
     }
-    else { // if not new, update as appropriate
-      if (r->length < h_find->second.minLength) {
-        h_find->second.minLength = r->length;
+    gzclose(z);
+  }
+  else if (f == NULL && len > 0 && filename[len-1] != 'z') {
+    // plain file, map it into memory and parse the lines where they are.
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {printf("Error reading from file %s\n", filename); exit(0); }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {printf("Error reading from file %s\n", filename); exit(0); }
+
+    if (st.st_size > 0) {
+      const char *map = (const char *) mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {printf("Error mapping file %s into memory\n", filename); exit(0); }
+      madvise((void *) map, st.st_size, MADV_SEQUENTIAL);
+
+      const char *mapEnd = map + st.st_size;
+      if (st.st_size >= sizeof(RSW_binaryHeader) &&
+          memcmp(map, RSW_BINARY_MAGIC, sizeof(RSW_BINARY_MAGIC)) == 0) {
+        numLines = add_binary_data(map, st.st_size, filename);
+        mapEnd = map; // nothing left to parse as text
       }
-      if (r->length > h_find->second.maxLength) {
-        h_find->second.maxLength = r->length;
+      for(const char *line = map; line < mapEnd; ) {
+        const char *end = (const char *) memchr(line, '\n', mapEnd-line);
+        if (end == NULL) end = mapEnd;
+        if (! add_data_line(line, end)) break;
+        numLines++;
+        line = end+1;
       }
+      munmap((void *) map, st.st_size);
     }
-    r->halfKey = key;
-    r->otherHalfKey = otherKey;
+    close(fd);
+  }
+  else {
+    if (f == NULL) {printf("Error reading from file %s\n", filename); exit(0); }
 
-    // what position on this would be at the split
-    if (r->side == 'L' && r->direction == '+' ||
-        r->side == 'R' && r->direction == '-') {
-      r->splitPos = r->position + r->length;
-    }
-    else {
-      r->splitPos = r->position;
+    // read data file one line at a time.
+    int result=1;
+    while (result > 0) {
+      result = get_line(f, sLine, MAX_LINE);
+      if (result < 0) {
+        printf("Error reading data file %s, line exceeded %i characters.\n", filename, MAX_LINE);
+        break;
+      }
+      if (! add_data_line(sLine, sLine + strlen(sLine))) break;
+      numLines++;
     }
-        
-    data.push_back(*r);        // save into vector
-    delete r;
-    //if (data.size() >= 15000000) break; // cut off early, for debugging to prevent program from running for too long.
+
+    pclose(f);
   }
 
-  fclose(f);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+  printf("Read %li lines of read data in %.2lf seconds, %.0lf lines/sec\n",
+         numLines, seconds, seconds > 0 ? numLines / seconds : 0.0);
+  return numLines;
 }
 
 /*
@@ -284,19 +892,15 @@ void read_knownGene(const char *filename) {
     i=0;
     while (tempA != NULL) {
       string temp= tempA; temp.shrink_to_fit();
-      pair<unordered_set<string>::iterator,bool> result;
       switch (i) {
       case 0:
-        result = stringTable.insert(temp);
-        rk->id1 = (result.first)->c_str();
+        rk->id1 = stringTable.intern(temp.c_str(), temp.size());
         break;
       case 1:
-        result = stringTable.insert(temp);
-        rk->id2 = (result.first)->c_str();
+        rk->id2 = stringTable.intern(temp.c_str(), temp.size());
         break;
       case 2:
-        result = stringTable.insert(temp);
-        rk->chromosome = (result.first)->c_str();
+        rk->chromosome = stringTable.intern(temp.c_str(), temp.size());
         break;
       case 3:
         rk->direction = temp[0];
@@ -326,6 +930,62 @@ void read_knownGene(const char *filename) {
   fclose(f);
 }
 
+/*
+  Function: index_knownGene, build index used by find_knownGene.  Must be
+            called after data_known has been sorted with compare_data_known.
+
+  Records of a chromosome are contiguous and sorted by position1, so we
+  only need the range for each chromosome and the running max of position2.
+*/
+void index_knownGene() {
+  knownChromRange.clear();
+  knownMaxEnd.resize(data_known.size());
+  int first = 0;
+  for(int k=0; k < data_known.size(); k++) {
+    if (k == 0 || data_known[k].chromosome != data_known[k-1].chromosome) {
+      first = k;
+      knownMaxEnd[k] = data_known[k].position2;
+    }
+    else {
+      knownMaxEnd[k] = max(knownMaxEnd[k-1], data_known[k].position2);
+    }
+    knownChromRange[data_known[k].chromosome] = make_pair(first, k+1);
+  }
+}
+
+/*
+  Function: find_knownGene, find the gene that contains positions lo through hi
+            on the given chromosome.
+
+  Return: index into data_known of the first such gene (in sorted order), -1 if none.
+*/
+int find_knownGene(unsigned int chromosome, long int lo, long int hi) {
+  auto range = knownChromRange.find(chromosome);
+  if (range == knownChromRange.end()) return -1;
+
+  int first = range->second.first, last = range->second.second;
+
+  // only genes that start at or before lo can contain it
+  int b = first, e = last;
+  while (b < e) {
+    int m = b + (e-b)/2;
+    if (data_known[m].position1 <= lo) b = m+1;
+    else e = m;
+  }
+  last = b;
+
+  // knownMaxEnd is non-decreasing, so the first index where it reaches hi
+  // is the first gene whose end is at least hi.
+  b = first; e = last;
+  while (b < e) {
+    int m = b + (e-b)/2;
+    if (knownMaxEnd[m] < hi) b = m+1;
+    else e = m;
+  }
+  if (b == last) return -1;
+  return b;
+}
+
 /*
   Function: read_boundaries, similar to read_data but read the format of the
             refFlat file of intron/extron boundaries.
@@ -348,19 +1008,15 @@ void read_boundaries(const char *filename) {
     i=0;
     while (tempA != NULL) {
       string temp = tempA; temp.shrink_to_fit();
-      pair<unordered_set<string>::iterator,bool> result;
       switch (i) {
         case 0:
-          result = stringTable.insert(temp);
-          rk->id1 = (result.first)->c_str();
+          rk->id1 = stringTable.intern(temp.c_str(), temp.size());
           break;
         case 1:
-          result = stringTable.insert(temp);
-          rk->id2 = (result.first)->c_str();
+          rk->id2 = stringTable.intern(temp.c_str(), temp.size());
           break;
         case 2:
-          result = stringTable.insert(temp);
-          rk->chromosome = (result.first)->c_str();
+          rk->chromosome = stringTable.intern(temp.c_str(), temp.size());
           break;
         case 3:
           rk->direction = temp[0];
@@ -394,58 +1050,52 @@ void read_boundaries(const char *filename) {
   }
 
   fclose(f);
-}
 
-/*
-  Function:   compare_dataById, used for sorting input data
-
-  Sorts based on id, direction, chromosome, position
-*/
-bool compare_dataById(RSW const &aa, RSW const &bb) {
-  int temp = aa.id-bb.id;
-  if (temp < 0) return true;
-  else if (temp > 0) return false;
-
-  if (aa.direction < bb.direction) 
-    return true;
-  else if (bb.direction < aa.direction)
-    return false;
-
-  temp = aa.chromosome-bb.chromosome;
-  if (temp < 0) return true;
-  else if (temp > 0) return false;
-
-  if (aa.position < bb.position) return true;
-  else return false;
+  // index the boundaries for is_novel
+  boundaryIndex.clear();
+  for(int j=0; j < data_boundaries.size(); j++) {
+    RSW_boundaryKey key;
+    key.chromosome = data_boundaries[j].chromosome;
+    key.length = data_boundaries[j].length;
+    boundaryIndex[key].push_back(make_pair(data_boundaries[j].position1, data_boundaries[j].position2));
+  }
+  for(auto it=boundaryIndex.begin(); it != boundaryIndex.end(); it++) {
+    sort(it->second.begin(), it->second.end());
+  }
 }
 
 /*
-  Function:   compare_dataToSort, used for sorting input data
+  Function: is_novel, check a junction against the intron boundary file.
 
-  Sorts based on chromosome, position, id
+  Return: false if there is a boundary on the same chromosome with the same length
+          whose positions are both within supportPosTolerance of the junction's
+          supporting range, true otherwise.
 */
-bool compare_dataByChromPos(RSW const &aa, RSW const &bb) {
-  int temp = aa.chromosome - bb.chromosome;
-  if (temp < 0) return true;
-  else if (temp > 0) return false;
-
-  int position = aa.splitPos - bb.splitPos;
-  if (position < 0) return true;
-  else if (position > 0) return false;
-  
-  return false;
+bool is_novel(RSW_splice *sp) {
+  RSW_boundaryKey key;
+  key.chromosome = sp->chromosome;
+  key.length = sp->positionLarger - sp->positionSmaller;
+  auto found = boundaryIndex.find(key);
+  if (found == boundaryIndex.end()) return true;
+
+  vector<pair<long int, long int> > &positions = found->second;
+  auto it = lower_bound(positions.begin(), positions.end(),
+                        make_pair(sp->minSmallSupport - supportPosTolerance, LONG_MIN));
+  for(; it != positions.end() && it->first <= sp->minSmallSupport + supportPosTolerance; it++) {
+    if (abs(sp->maxLargeSupport - it->second) <= supportPosTolerance)
+      return false;
+  }
+  return true;
 }
 
-
 /*
   Function:  compare_data_known, used for sorting results from refFlat file
 
   Sort based on chromosome and position.
 */
 bool compare_data_known(RSW_Known const &aa, RSW_Known const &bb) {
-  int temp = aa.chromosome-bb.chromosome;
-  if (temp < 0) return true;
-  else if (temp > 0) return false;
+  if (aa.chromosome < bb.chromosome) return true;
+  else if (aa.chromosome > bb.chromosome) return false;
 
   return aa.position1 < bb.position1;
 }
@@ -458,14 +1108,9 @@ bool compare_data_known(RSW_Known const &aa, RSW_Known const &bb) {
   before computing supporting reads.
 */
 bool compare_spliceByChromPos(RSW_splice *aa, RSW_splice *bb) {
-  int temp = aa->chromosome-bb->chromosome;
-  if (temp < 0) return true;
-  else if (temp > 0) return false;
-
-  if (aa->positionSmaller < bb->positionSmaller) return true;
-  else if (aa->positionSmaller > bb->positionSmaller) return false;
-  
-  return false;
+  unsigned long long ka = ((unsigned long long) aa->chromosome << 33) | aa->positionSmaller;
+  unsigned long long kb = ((unsigned long long) bb->chromosome << 33) | bb->positionSmaller;
+  return ka < kb;
 }
 
 
@@ -617,8 +1262,8 @@ void openOutputFiles() {
 void printSplice(FILE *f, RSW_splice *sp) {
   fprintf(f,
       "%s\t%s\t%li\t%li\t%li\t%li\t%li--%li\t%s", 
-      sp->geneName, 
-      sp->chromosome,
+      stringTable.str(sp->geneName), 
+      stringTable.str(sp->chromosome),
       sp->numSupport, //full support 
       sp->numSupportHalves, //half support
       sp->numSupportTotal, //"total" support
@@ -633,26 +1278,27 @@ void printSplice(FILE *f, RSW_splice *sp) {
 string getHalfStats() {
   char s[10000];
   
-  int halfCount = 0;
-  int minMax = -1, minMin = -1, maxMax = -1, maxMin = -1, minTotal = 0, maxTotal = 0;
-  for(auto it=data_halves.begin(); it != data_halves.end(); it++) {
-    halfCount++;
-    int min = it->second.minLength, max = it->second.maxLength;
-    minTotal += min;  maxTotal += max;
-    if (minMax == -1 || min > minMax) minMax = min;
-    if (minMin == -1 || min < minMin) minMin = min;
-    if (maxMax == -1 || max > maxMax) maxMax = max;
-    if (maxMin == -1 || max < maxMin) maxMin = max;
-  }
-  sprintf(s, "Half lengths:                               min %lf avg, range %li-%li;  max %lf avg, range %li-%li",
-   (double) minTotal / halfCount, minMin, minMax,
-   (double) maxTotal / halfCount, maxMin, maxMax);
+  sprintf(s, "Half lengths:                               min %lf avg, range %i-%i;  max %lf avg, range %i-%i",
+   (double) halfMinTotal / halfCount, halfMinMin, halfMinMax,
+   (double) halfMaxTotal / halfCount, halfMaxMin, halfMaxMax);
 
   return s;
 }
 
 
 
+/*
+  Function:  end_phase, writes the statistics for the phase of the program that
+             just finished to $RSF_STATS_FILE (see rsf_stats.h) and starts
+             timing the next phase.
+*/
+void end_phase(long long records, const char *nextPhase) {
+  phaseStats.records = records;
+  rsf_stats_end(&phaseStats);
+  rsf_stats_begin(&phaseStats, "sp4", nextPhase);
+}
+
+
 /*
   Function:  printStats, prints statistics gathered so far to the
              opened file - useful for debugging to see some partial
@@ -672,11 +1318,12 @@ void printStats(FILE *f) {
   endTime = time(NULL);
   fprintf(f, "Finished processing data, results written to files.\n");
   fprintf(f, "Number of entries in data file:             %li\n", data.size());
-  fprintf(f, "Number of different reads:                  %i\n", numDifferentReads);
+  fprintf(f, "Number of different reads:                  %li\n", numDifferentReads);
   fprintf(f, "Number of entries in refFlat file:          %li\n", data_known.size());
   fprintf(f, "Number of entries in refFlat boundary file: %li\n", data_boundaries.size());
   fprintf(f, "Number of matches:                          %li\n", data_splice.size());
   fprintf(f, "String table size:                          %li\n", stringTable.size());
+  fprintf(f, "String table memory:                        %li bytes\n", stringTable.bytesUsed());
   fprintf(f, "VmRSS, memory resident set size:            %s %s\n", mem, units);
   fprintf(f, "Total time to process:                      %li seconds\n", endTime-beginTime);
 
@@ -693,27 +1340,27 @@ void printStats(FILE *f) {
   check data_splice[sp1] against data[i_data].
   Return: 1 if they are a match
           0 if not a match
-   -1 if should break out of loop back in main (stop incrementing i_data because past data_splice[sp1] in data)
+   -1 if should break out of loop back in compute_support (stop incrementing i_data
+      because past data_splice[sp1] in data, or reached dataEnd)
  */
-int checkHalf(int sp1, int i_data, bool smallEnd) {
-  int c = data_splice[sp1]->chromosome - data[i_data].chromosome;
-  
+int checkHalf(size_t sp1, size_t i_data, bool smallEnd, size_t dataEnd) {
+  if (i_data >= dataEnd) return -1;
+
   // if not same chromosome, either wait for sp1 to catch up, or let i_data catch up
-  if (c < 0) return -1;
-  else if (c == 0) {
-    int p;
-    if (smallEnd) p = data_splice[sp1]->positionSmaller - data[i_data].splitPos;
-    else p = data_splice[sp1]->positionLarger - data[i_data].splitPos;
+  if (data_splice[sp1]->chromosome < data[i_data].chromosome) return -1;
+  else if (data_splice[sp1]->chromosome == data[i_data].chromosome) {
+    long int p;
+    if (smallEnd) p = data_splice[sp1]->positionSmaller - data[i_data].splitPos();
+    else p = data_splice[sp1]->positionLarger - data[i_data].splitPos();
     if ( p < 0) return -1;
     else if (p == 0) { // a match
-      auto fOther = data_halves.find(data[i_data].otherHalfKey);
-      if (data_splice[sp1]->direction == data[i_data].direction && 
-   (fOther == data_halves.end() ||
-    fOther->second.maxLength < data[i_data].totalReadLength - data[i_data].length)) {
+      if (data_splice[sp1]->direction == data[i_data].direction() && 
+   data[i_data].otherHalfMissing()) {
  // then this is a half that is at the right position and doesn't have a matching
  // other half (presumably because of being in the max file) that is long enough so let's count it.
  return 1;
       }
+      return 0;
     }
     else // p > 0
       return 0;
@@ -723,75 +1370,49 @@ int checkHalf(int sp1, int i_data, bool smallEnd) {
 }
 
 
-int main(int argc, char *argv[]) {
-  setpriority(0, 0, 20); // so other processes get priority over this one
-
-  beginTime = time(NULL);
-
-  // read options, from file or default options
-  if (argc > 1) 
-    readOptionsFromFile(argv[1]);
-  else 
-    setDefaultOptions();
-
-  // write out options to all output files and stdout
-  openOutputFiles();
-
-  printCurrentOptions(stdout);
-  printCurrentOptions(fKnown);
-  //  printCurrentOptions(fKnownFull);
-  printCurrentOptions(fUnknown);
-  //  printCurrentOptions(fUnknownFull);
-  printCurrentOptions(fSplitPairs);
-
-
-  // read from refFlat file into data_known array, 
-  read_knownGene(refFlatFile);
-  sort(data_known.begin(), data_known.end(), compare_data_known);
-  printf("Done reading/sorting refFlat, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
-
-  // read from refFlat boundary file into data_boundaries array, 
-  read_boundaries(refFlatBoundaryFile);
-  printf("Done reading refFlat intron/exon boundaries, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
+/*
+  Function: find_matched_pairs, look at all pairs of read segments in
+            data[begin] .. data[end-1], looking for matches.
 
-  // read the read data
-  read_data(sampleDataFile);
-  halfStatsString = getHalfStats();
-  printf("Done reading read data, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
+  Parameters: begin, end - range of data to look at, must not split the
+              records of a read id.  splices - found junctions are added to this.
 
-  // sort the read data
-  sort(data.begin(), data.end(), compare_dataById);
-  printf("Done sorting read data, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
+  Return: number of different reads in the range.
 
-  // look at all pairs of read segments, looking for matches
-  numDifferentReads = 0;
-  const int inputSize = data.size();
-  for(int left=0; left < inputSize; left++) {
-    int right;
-    if (left == 0 || (data[left].id  != data[left-1].id) ) {
-      numDifferentReads++;
+  data must be sorted with compare_dataById.  Called from several threads at
+  once with different ranges, so only reads global data.
+*/
+long int find_matched_pairs(size_t begin, size_t end, vector<RSW_splice *> &splices) {
+  long int numReads = 0;
+
+  // splices found so far for the current read id.  data is sorted by id, so a
+  // splice can only be a duplicate of one from the same read - the set is
+  // emptied each time we move on to a new read id.
+  unordered_set<RSW_spliceKey, RSW_spliceKeyHash> spliceKeys;
+
+  for(size_t left=begin; left < end; left++) {
+    size_t right;
+    if (left == begin || (data[left].id  != data[left-1].id) ) {
+      numReads++;
+      spliceKeys.clear();
     }
 
-    for(right=left+1; right < inputSize; right++) {
+    for(right=left+1; right < end; right++) {
       // read segments are ordered by id/chromosome/strand, so if 
       // there isn't a match we can skip the rest of the read segments
       // for "right", and go to the next iteration of the "left" loop
       if (data[left].id != data[right].id ||
-          data[left].direction != data[right].direction ||
+          data[left].direction() != data[right].direction() ||
           data[left].chromosome != data[right].chromosome) {
         break;
       }
 
-      if (data[right].position - data[left].position > maxDistance) {
+      if ((long int) data[right].position - data[left].position > maxDistance) {
         break;
       }
 
       // want it to be from two sides of the same segment
-      if (data[left].side == data[right].side) {
+      if (data[left].side() == data[right].side()) {
         continue;
       }
 
@@ -803,9 +1424,9 @@ int main(int argc, char *argv[]) {
       // calculate the end of the segments, since what is given
       // in the data is the beginning of the segments
       int endSmaller, endLarger; // splice is between endSmaller and endLarger
-      int first, second;
-      if (data[left].side == 'L' && data[left].direction == '+' ||
-          data[left].side == 'R' && data[left].direction == '-') { 
+      size_t first, second;
+      if (data[left].side() == 'L' && data[left].direction() == '+' ||
+          data[left].side() == 'R' && data[left].direction() == '-') { 
         first = left; second = right;
       }
       else { 
@@ -820,37 +1441,21 @@ int main(int argc, char *argv[]) {
       if (spliceLength < minSpliceLength) continue;
 
       // check if we already have this splice from this read...
-      int i;
-      for(i=0; i < data_splice.size(); i++) {
-        if (data_splice[i]->positionSmaller != endSmaller ||
-          data_splice[i]->positionLarger != endLarger ||
-          data_splice[i]->id != data[left].id ||
-          data_splice[i]->chromosome != data[left].chromosome)
-        {
-          continue;
-        }
-        break;
-      }
+      RSW_spliceKey key;
+      key.id = data[left].id;
+      key.chromosome = data[left].chromosome;
+      key.positionSmaller = endSmaller;
+      key.positionLarger = endLarger;
       // if already have this exact splice for this chromosome from this read, don't include it again.
-      if (i < data_splice.size()) continue;
+      if (! spliceKeys.insert(key).second) continue;
 
       // note: could print this match here, step 5 done.
 
       // look for this in the known gene...
-      int k; int foundInGene = 0;
-      for(k=0; k < data_known.size(); k++) {
-        if ((((data[left].chromosome == data_known[k].chromosome) &&
-          (data[left].position >= data_known[k].position1 &&
-           data[right].position >= data_known[k].position1) &&
-          (data[left].position <= data_known[k].position2 &&
-           data[right].position <= data_known[k].position2)))) 
-        {
-          if (foundInGene) ;//printf("DUPLICATE_"); // duplicate //TODO: remove this? -aaron
-          foundInGene = 1;
-          break; // just cut off search, don't look for duplicates
-        }
-      }
-      int geneIndex = k;
+      int geneIndex = find_knownGene(data[left].chromosome,
+                                     min(data[left].position, data[right].position),
+                                     max(data[left].position, data[right].position));
+      int foundInGene = geneIndex >= 0;
       
       // make a new splice record and put into vector of splices
       RSW_splice *sp = new RSW_splice;
@@ -864,12 +1469,12 @@ int main(int argc, char *argv[]) {
         sp->geneUnknown = 0;
       } 
       else {
-        sp->geneName = unfound_string;
+        sp->geneName = unfound_id;
         sp->geneUnknown = 1;
       }
       sp->id = data[left].id;
       sp->chromosome = data[left].chromosome;
-      sp->direction = data[left].direction;
+      sp->direction = data[left].direction();
       sp->positionSmaller = sp->minSmallSupport = endSmaller;
       sp->positionLarger = sp->maxLargeSupport = endLarger;
       sp->alreadyReported = false;
@@ -877,37 +1482,36 @@ int main(int argc, char *argv[]) {
       sp->numSupport = sp->numSupportHalves = sp->numSupportTotal = 0;
       sp->leftLength = data[left].length;
 
-      data_splice.push_back(sp);
+      splices.push_back(sp);
     }
   }
 
-  printf("Done finding matched pairs, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
-
-  // re-sort input data by chromosome and position
-  sort(data.begin(), data.end(), compare_dataByChromPos);
-  printf("Done resorting input data by chromosome and position, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
-  
-  
-  // sort splices by chromosome and position
-  sort(data_splice.begin(), data_splice.end(), compare_spliceByChromPos);
 
-  printf("Done sorting matched pairs, total time elapsed %li seconds\n", time(NULL)-beginTime);
-  printStats(stdout);
+  return numReads;
+}
 
-  int i_lastEndSmaller = 0, i_lastEndLarger = 0;
 
-  // compute supporting reads, print them out on the fly.
+/*
+  Function: compute_support, compute supporting reads for junctions
+            data_splice[spBegin] .. data_splice[spEnd-1], which must all be on
+            one chromosome.  data[dataBegin] .. data[dataEnd-1] are the halves
+            on that chromosome.
+
+  data_splice must be sorted with compare_spliceByChromPos and data with
+  compare_dataByChromPos.  Called from several threads at once for different
+  chromosomes, so only changes the junctions in its own range.
+*/
+void compute_support(size_t spBegin, size_t spEnd, size_t dataBegin, size_t dataEnd) {
+  size_t i_lastEndSmaller = dataBegin;
 
-  for(int sp1=0; sp1 < data_splice.size(); sp1++) {
-    int sp2;
+  for(size_t sp1=spBegin; sp1 < spEnd; sp1++) {
+    size_t sp2;
 
     if (data_splice[sp1]->alreadyReported) continue;
     
-    unordered_set <const char *> supported_read_ids; // list of supporting reads
-    unordered_set <const char *> supported_read_ids_halves; // list of supporting reads
-    unordered_set <const char *> supported_read_ids_both;   // list of supporting reads
+    unordered_set <unsigned int> supported_read_ids; // list of supporting reads
+    unordered_set <unsigned int> supported_read_ids_halves; // list of supporting reads
+    unordered_set <unsigned int> supported_read_ids_both;   // list of supporting reads
     unordered_set <RSW_splice *> supported_splices;
     //unordered_set <int> supported_halves; // int is the index into data - note that only works as long as data is not resorted
     supported_read_ids.insert(data_splice[sp1]->id);
@@ -915,7 +1519,7 @@ int main(int argc, char *argv[]) {
     supported_splices.insert(data_splice[sp1]);
 
     // scan through the following reads ...
-    for(sp2=sp1; sp2 < data_splice.size(); sp2++) {
+    for(sp2=sp1; sp2 < spEnd; sp2++) {
       // see if these reads support each other
 
       // if not same chromosome, no support.
@@ -958,7 +1562,7 @@ int main(int argc, char *argv[]) {
     // match up but don't have the other half because it is probably
     // in the max file.
     for(; ; i_lastEndSmaller++)  {
-      int result = checkHalf(sp1, i_lastEndSmaller, true);
+      int result = checkHalf(sp1, i_lastEndSmaller, true, dataEnd);
       if (result < 0) {
         break;
       }
@@ -971,8 +1575,8 @@ int main(int argc, char *argv[]) {
     }
 
     // and similarly, check the larger half of the split.
-    for(int i_data = i_lastEndSmaller; ; i_data++)  {
-      int result = checkHalf(sp1, i_data, false);
+    for(size_t i_data = i_lastEndSmaller; ; i_data++)  {
+      int result = checkHalf(sp1, i_data, false, dataEnd);
       if (result < 0) break;
       else if (result > 0) {
         // then this is a half that is at the right position and doesn't have a matching
@@ -991,13 +1595,170 @@ int main(int argc, char *argv[]) {
       data_splice[sp1]->numSupportTotal = supported_read_ids_both.size();
 
       for(const auto& x: supported_splices) {
- x->alreadyReported = true;
+        x->alreadyReported = true;
       }       
     }
   }
+}
+
+
+int main(int argc, char *argv[]) {
+  setpriority(0, 0, 20); // so other processes get priority over this one
+
+  beginTime = time(NULL);
+  rsf_stats_begin(&totalStats, "sp4", "total");
+  rsf_stats_begin(&phaseStats, "sp4", "read_refflat");
+  unfound_id = stringTable.intern(unfound_string);
+
+  // read options, from file or default options.  --threads N, --memory MB
+  // and --temp-dir DIR can be given before or after the options file.
+  const char *optionsFile = NULL;
+  for(int a=1; a < argc; a++) {
+    if (strcmp(argv[a], "--threads") == 0 && a+1 < argc) {
+      numThreads = atoi(argv[++a]);
+      if (numThreads < 1) numThreads = 1;
+    }
+    else if (strcmp(argv[a], "--memory") == 0 && a+1 < argc) {
+      memoryBudget = atol(argv[++a]);
+    }
+    else if (strcmp(argv[a], "--temp-dir") == 0 && a+1 < argc) {
+      tempDir = argv[++a];
+    }
+    else optionsFile = argv[a];
+  }
+  if (optionsFile != NULL) 
+    readOptionsFromFile(optionsFile);
+  else 
+    setDefaultOptions();
+  printf("Using %i thread(s).\n", numThreads);
+  if (memoryBudget > 0)
+    printf("Sorting read data externally, using %li MB at a time and temporary files in %s\n", memoryBudget, tempDir);
+
+  // write out options to all output files and stdout
+  openOutputFiles();
+
+  printCurrentOptions(stdout);
+  printCurrentOptions(fKnown);
+  //  printCurrentOptions(fKnownFull);
+  printCurrentOptions(fUnknown);
+  //  printCurrentOptions(fUnknownFull);
+  printCurrentOptions(fSplitPairs);
+
+
+  // read from refFlat file into data_known array, 
+  read_knownGene(refFlatFile);
+  sort(data_known.begin(), data_known.end(), compare_data_known);
+  index_knownGene();
+  printf("Done reading/sorting refFlat, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  phaseStats.bytesIn = rsf_stats_file_size(refFlatFile);
+  end_phase(data_known.size(), "read_boundaries");
+
+  // read from refFlat boundary file into data_boundaries array, 
+  read_boundaries(refFlatBoundaryFile);
+  printf("Done reading refFlat intron/exon boundaries, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  phaseStats.bytesIn = rsf_stats_file_size(refFlatBoundaryFile);
+  end_phase(data_boundaries.size(), "read_data");
+
+  // read the read data
+  long int numLines = read_data(sampleDataFile);
+  printf("Done reading read data, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  phaseStats.bytesIn = totalStats.bytesIn = rsf_stats_file_size(sampleDataFile);
+  totalStats.records = numLines;
+  end_phase(numLines, "sort_data");
+
+  // sort the read data
+  if (memoryBudget > 0) {
+    // read_data has written the data to sorted runs, merge them.  the
+    // lengths of the halves are set while merging.
+    write_run(compare_dataById);
+    vector<RSW>().swap(runBuffer);
+    merge_runs(compare_dataById, true);
+  }
+  else {
+    parallel_sort(data.begin(), data.end(), compare_dataById);
+
+    // lengths of the halves of each read, now that all of a read's records are together
+    compute_half_data();
+  }
+  halfStatsString = getHalfStats();
+  printf("Done sorting read data, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  end_phase(data.size(), "matched_pairs");
+
+  // look at all pairs of read segments, looking for matches.  data is split
+  // into parts at read id boundaries, the parts are done in parallel, and
+  // then the splices from each part are put together in order so the
+  // result is the same as doing it with one thread.
+  vector<size_t> partStart =
+    part_starts(data.size(), numThreads > 1 ? numThreads * 8 : 1,
+                [&](size_t i) { return data[i].id == data[i-1].id; });
+
+  vector<vector<RSW_splice *> > partSplices(partStart.size()-1);
+  vector<long int> partReads(partStart.size()-1);
+  run_parallel(partSplices.size(), [&](int p) {
+      partReads[p] = find_matched_pairs(partStart[p], partStart[p+1], partSplices[p]);
+    });
+
+  numDifferentReads = 0;
+  for(int p=0; p < partSplices.size(); p++) {
+    numDifferentReads += partReads[p];
+    data_splice.insert(data_splice.end(), partSplices[p].begin(), partSplices[p].end());
+    vector<RSW_splice *>().swap(partSplices[p]);
+  }
+
+  printf("Done finding matched pairs, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  end_phase(data_splice.size(), "sort_data_by_position");
+
+  // re-sort input data by chromosome and position
+  if (memoryBudget > 0)
+    external_sort_data(compare_dataByChromPos);
+  else
+    parallel_sort(data.begin(), data.end(), compare_dataByChromPos);
+  printf("Done resorting input data by chromosome and position, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  end_phase(data.size(), "sort_splices");
+  
+  
+  // sort splices by chromosome and position
+  parallel_sort(data_splice.begin(), data_splice.end(), compare_spliceByChromPos);
+
+  printf("Done sorting matched pairs, total time elapsed %li seconds\n", time(NULL)-beginTime);
+  printStats(stdout);
+  end_phase(data_splice.size(), "supporting_reads");
+
+  // compute supporting reads.  junctions can only be supported by junctions
+  // and halves on the same chromosome, so each chromosome is done separately,
+  // in parallel.
+  vector<size_t> shardStart;
+  for(size_t sp=0; sp < data_splice.size(); sp++) {
+    if (sp == 0 || data_splice[sp]->chromosome != data_splice[sp-1]->chromosome)
+      shardStart.push_back(sp);
+  }
+  shardStart.push_back(data_splice.size());
+
+  unordered_map<unsigned int, pair<size_t,size_t> > dataChromRange; // chromosome -> [first,last+1) in data
+  for(size_t i=0; i < data.size(); i++) {
+    if (i == 0 || data[i].chromosome != data[i-1].chromosome)
+      dataChromRange[data[i].chromosome] = make_pair(i, i);
+    dataChromRange[data[i].chromosome].second = i+1;
+  }
+
+  run_parallel(shardStart.size()-1, [&](int shard) {
+      size_t dataBegin = 0, dataEnd = 0;
+      auto range = dataChromRange.find(data_splice[shardStart[shard]]->chromosome);
+      if (range != dataChromRange.end()) {
+        dataBegin = range->second.first; dataEnd = range->second.second;
+      }
+      compute_support(shardStart[shard], shardStart[shard+1], dataBegin, dataEnd);
+    });
 
   printf("Done computing supporting reads, total time elapsed %li seconds\n", time(NULL)-beginTime);
   printStats(stdout);
+  end_phase(data_splice.size(), "save_results");
 
   // sort splices by chromosome and length, and # supporting reads
   //sort(data_splice.begin(), data_splice.end(), compare_spliceByChromLen);
@@ -1021,23 +1782,23 @@ int main(int argc, char *argv[]) {
   //  printStats(fUnknownFull);
   printStats(fSplitPairs);
 
-  int k;
+  size_t k;
 
 
   // save all the splices, and reads that support each one into .splitPairs file - this is
   // the full results, with many duplicates of splices.  The file also can be HUGE, so
   // generally this file will often get deleted unless needed for debugging.
   fprintf(fSplitPairs, "Id\tGene\tChr\t# Supporting reads\t# Supporting halves\t# Supporting total\tLength\tSplice region\tSupporting splice range\tLeft side length\n");
-  int i_data=0;
+  size_t i_data=0;
   for(k=0; k < data_splice.size() && i_data < data.size();) {
     if (i_data == data.size() ||
  data_splice[k]->chromosome < data[i_data].chromosome ||
  (data_splice[k]->chromosome == data[i_data].chromosome && 
-  data_splice[k]->positionSmaller < data[i_data].splitPos)) {
+  data_splice[k]->positionSmaller < data[i_data].splitPos())) {
       // print a splice
       fprintf(fSplitPairs, "%s\t%s\t%s\t%li\t%li\t%li\t%li\t%li-%li\t%li-%li\t%li\n", 
-       data_splice[k]->id, data_splice[k]->geneName,
-       data_splice[k]->chromosome,
+       stringTable.str(data_splice[k]->id), stringTable.str(data_splice[k]->geneName),
+       stringTable.str(data_splice[k]->chromosome),
        data_splice[k]->numSupport,
        data_splice[k]->numSupportHalves,
        data_splice[k]->numSupportTotal,
@@ -1050,18 +1811,16 @@ int main(int argc, char *argv[]) {
     }
     else {
       // print a half that doesn't have a matching other half that is big enough
-      auto fOther = data_halves.find(data[i_data].otherHalfKey);
-      if (fOther == data_halves.end() ||
-          fOther->second.maxLength < data[i_data].totalReadLength - data[i_data].length) {
+      if (data[i_data].otherHalfMissing()) {
         fprintf(fSplitPairs, "%s\t%s\t%s\t%li\t%li\t%li\t%li\t%li-%li\t%li-%li\t%li %c %c\n",
-          data[i_data].id, "???",
-          data[i_data].chromosome,
+          stringTable.str(data[i_data].id), "???",
+          stringTable.str(data[i_data].chromosome),
           0,0,0,
           0,
-          data[i_data].position,data[i_data].splitPos,
+          (long int) data[i_data].position,data[i_data].splitPos(),
           0,0,
-          data[i_data].length,
-          data[i_data].side, data[i_data].direction
+          (long int) data[i_data].length,
+          data[i_data].side(), data[i_data].direction()
         );
       }
       i_data++;
@@ -1079,21 +1838,7 @@ int main(int argc, char *argv[]) {
     if (! data_splice[k]->print) continue;
 
     // check if novel or not.
-    int j;
-    data_splice[k]->novel = true;
-    for(j=0; j < data_boundaries.size(); j++) {
-      if (data_splice[k]->positionLarger-data_splice[k]->positionSmaller != 
-          data_boundaries[j].length) {
-        continue;
-      }
-      if (abs(data_splice[k]->minSmallSupport-data_boundaries[j].position1) <= supportPosTolerance &&
-          abs(data_splice[k]->maxLargeSupport-data_boundaries[j].position2) <= supportPosTolerance) {
-        break;
-      }
-    }
-    if (j < data_boundaries.size()) { // if found in the boundaries data, not novel
-      data_splice[k]->novel = false;
-    }
+    data_splice[k]->novel = is_novel(data_splice[k]);
 
     // going into known file or unknown
     if (data_splice[k]->geneUnknown) {
@@ -1108,12 +1853,16 @@ int main(int argc, char *argv[]) {
     fprintf(f, "\n");
   }
 
+  phaseStats.bytesOut = totalStats.bytesOut = ftell(fKnown) + ftell(fUnknown) + ftell(fSplitPairs);
   fclose(fKnown); //fclose(fKnownFull);
   fclose(fUnknown); //fclose(fUnknownFull);
   fclose(fSplitPairs);
 
   printf("Done saving results, total time elapsed %li seconds\n", time(NULL)-beginTime);
   printStats(stdout);
+  phaseStats.records = data_splice.size();
+  rsf_stats_end(&phaseStats);
+  rsf_stats_end(&totalStats);
 
   // free memory.  good to do so we can run a memory checker and verify
   // we don't have any memory leaks.
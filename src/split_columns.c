@@ -2,6 +2,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "RSW_binary.h"
+#include "rsf_stats.h"
 
 
 /*
@@ -9,9 +15,26 @@
 
  Oct 27, 2015 - fixed bug with filename of output that was causing
  filename to be wrong sometimes, which caused the pipeline to also fail. 
+
+ Oct 16, 2026 - added -b option, to write the binary format in RSW_binary.h
+ (file.split1stcolumn.bin) instead of text, so splitPairs does not have to
+ parse the text again.
+
+ Oct 16, 2026 - input may be gzip-compressed, and added -z option to write
+ gzip-compressed text output (file.split1stcolumn.gz).  file.gz is written
+ to file.split1stcolumn, not file.gz.split1stcolumn.
+
+ Oct 16, 2026 - write the time and memory used, bytes in and out and lines
+ formatted for each file to $RSF_STATS_FILE (see rsf_stats.h).
+
+ Oct 17, 2026 - -b writes the columns in blocks, through temporary files,
+ instead of keeping them all in memory until the end.  Only the strings
+ stay in memory.  A line with too few fields ends the input, as it does
+ when splitPairs reads the text, instead of being skipped.
 */
 
 #define SUFFIX ".split1stcolumn"
+#define GZ_SUFFIX ".gz"
 
 //D2FC08P1:143:D0KHCACXX:6:1101:1563:1953 2:N:0:-R-68-130/2  
 
@@ -70,16 +93,251 @@ void split_field(char *readName, int len) {
   //readName[i+2] = '\t';
 }
 
-void parse(char *filename) {
+/*
+ Binary output.  The columns are written one after the other, so they are
+ built up in blocks of BLOCK_RECORDS records: when a block is full the id
+ column is written straight to the output file (after a header that is
+ filled in at the end) and the other columns to a temporary file each,
+ which are copied onto the end of the output file when the input is done.
+ Only the read ids and chromosome names stay in memory, stored once each
+ in strings and found with a hash table.
+ */
+#define BLOCK_RECORDS 65536
+#define TEMP_COLUMNS 5   /* chromosome, position, length, totalReadLength, flags */
+
+struct binary_out {
+  FILE *out;
+  FILE *columnFile[TEMP_COLUMNS];
+  uint32_t *id, *chromosome, *position;   /* the current block */
+  uint16_t *length, *totalReadLength;
+  uint8_t *flags;
+  size_t blockRecords, numRecords;
+
+  char *strings;          /* '\0' terminated strings one after another */
+  size_t stringBytes, capBytes;
+  size_t *stringStart;    /* where string i starts in strings */
+  size_t numStrings, capStrings;
+  uint32_t *slots;        /* hash table, string number+1 or 0 if empty */
+  size_t numSlots;
+};
+
+void *xrealloc(void *p, size_t bytes) {
+  p = realloc(p, bytes);
+  if (!p) {
+    fprintf(stderr, "Out of memory making binary output. aborting\n");
+    exit(1);
+  }
+  return p;
+}
+
+/* make sure array p of elements of the given size has room for need elements */
+void *grow_array(void *p, size_t *cap, size_t need, size_t size) {
+  if (need <= *cap) return p;
+  while (*cap < need) *cap = *cap ? *cap * 2 : 1024;
+  return xrealloc(p, *cap * size);
+}
+
+size_t hash_string(const char *s, size_t len) {
+  size_t h = 14695981039346656037ULL, i; /* FNV-1a */
+  for (i = 0; i < len; i++) h = (h ^ (unsigned char) s[i]) * 1099511628211ULL;
+  return h;
+}
+
+/* return the number of s[0..len-1] in b->strings, adding it if it is new */
+uint32_t intern_string(struct binary_out *b, const char *s, size_t len) {
+  size_t h, i;
+  if ((b->numStrings+1) * 10 > b->numSlots * 7) { /* grow hash table */
+    size_t oldSlots = b->numSlots;
+    uint32_t *old = b->slots;
+    b->numSlots = oldSlots ? oldSlots * 2 : 1024;
+    b->slots = (uint32_t *)xrealloc(NULL, b->numSlots * sizeof(uint32_t));
+    memset(b->slots, 0, b->numSlots * sizeof(uint32_t));
+    for (i = 0; i < oldSlots; i++) {
+      if (!old[i]) continue;
+      const char *t = b->strings + b->stringStart[old[i]-1];
+      h = hash_string(t, strlen(t)) & (b->numSlots-1);
+      while (b->slots[h]) h = (h+1) & (b->numSlots-1);
+      b->slots[h] = old[i];
+    }
+    free(old);
+  }
+
+  h = hash_string(s, len) & (b->numSlots-1);
+  while (b->slots[h]) {
+    const char *t = b->strings + b->stringStart[b->slots[h]-1];
+    if (strncmp(t, s, len) == 0 && t[len] == '\0') return b->slots[h]-1;
+    h = (h+1) & (b->numSlots-1);
+  }
+
+  b->strings = (char *)grow_array(b->strings, &b->capBytes, b->stringBytes + len + 1, 1);
+  b->stringStart = (size_t *)grow_array(b->stringStart, &b->capStrings, b->numStrings + 1, sizeof(size_t));
+  memcpy(b->strings + b->stringBytes, s, len);
+  b->strings[b->stringBytes + len] = '\0';
+  b->stringStart[b->numStrings] = b->stringBytes;
+  b->stringBytes += len + 1;
+  b->slots[h] = b->numStrings + 1;
+  return b->numStrings++;
+}
+
+/*
+ Start binary output to out: write a header to be filled in by finish_binary
+ and open the temporary column files, next to outname.  They are removed
+ right away, so they go away when closed even if sfc is stopped.
+ Return 0 if a file could not be opened or written.
+ */
+int start_binary(struct binary_out *b, FILE *out, const char *outname) {
+  struct RSW_binaryHeader h;
+  char *tempname = (char *)xrealloc(NULL, strlen(outname) + 16);
+  int i;
+
+  memset(b, 0, sizeof(*b));
+  b->out = out;
+  for (i = 0; i < TEMP_COLUMNS; i++) {
+    sprintf(tempname, "%s.%i.tmp", outname, i);
+    b->columnFile[i] = fopen(tempname, "w+");
+    if (!b->columnFile[i]) {
+      fprintf(stderr, "Could not open %s for writing", tempname);
+      perror("");
+      free(tempname);
+      return 0;
+    }
+    unlink(tempname);
+  }
+  free(tempname);
+
+  b->id = (uint32_t *)xrealloc(NULL, BLOCK_RECORDS * sizeof(uint32_t));
+  b->chromosome = (uint32_t *)xrealloc(NULL, BLOCK_RECORDS * sizeof(uint32_t));
+  b->position = (uint32_t *)xrealloc(NULL, BLOCK_RECORDS * sizeof(uint32_t));
+  b->length = (uint16_t *)xrealloc(NULL, BLOCK_RECORDS * sizeof(uint16_t));
+  b->totalReadLength = (uint16_t *)xrealloc(NULL, BLOCK_RECORDS * sizeof(uint16_t));
+  b->flags = (uint8_t *)xrealloc(NULL, BLOCK_RECORDS * sizeof(uint8_t));
+
+  memset(&h, 0, sizeof(h));
+  return fwrite(&h, sizeof(h), 1, out) == 1;
+}
+
+/* write the current block of each column to its file, and empty the block */
+int flush_binary_block(struct binary_out *b) {
+  size_t n = b->blockRecords;
+  b->blockRecords = 0;
+  return fwrite(b->id, sizeof(uint32_t), n, b->out) == n &&
+    fwrite(b->chromosome, sizeof(uint32_t), n, b->columnFile[0]) == n &&
+    fwrite(b->position, sizeof(uint32_t), n, b->columnFile[1]) == n &&
+    fwrite(b->length, sizeof(uint16_t), n, b->columnFile[2]) == n &&
+    fwrite(b->totalReadLength, sizeof(uint16_t), n, b->columnFile[3]) == n &&
+    fwrite(b->flags, sizeof(uint8_t), n, b->columnFile[4]) == n;
+}
+
+/*
+ Add one line, after split_field, to the binary columns.  The fields used are
+ id, side, length of piece, total length of read, direction, chromosome, position.
+ Return 0 if the line does not have the 10 fields of a .split1stcolumn line.
+ splitPairs stops reading a text file at such a line, so the caller stops
+ there too and both formats give the same records.
+ */
+int add_binary_line(struct binary_out *b, const char *line) {
+  const char *field[10];
+  int numFields = 1;
+  field[0] = line;
+  while (numFields < 10) {
+    const char *c = strchr(field[numFields-1], '\t');
+    if (!c) break;
+    field[numFields++] = c+1;
+  }
+  if (numFields < 10) return 0;
+
+  long length = atol(field[2]), total = atol(field[3]), position = atol(field[6]);
+  if (length < 0 || length >= (1 << 15) || total < 0 || total >= (1 << 15) ||
+      position < 0 || position > UINT32_MAX) {
+    fprintf(stderr, "Value out of range in line. aborting: %s", line);
+    exit(1);
+  }
+
+  size_t i = b->blockRecords;
+  b->id[i] = intern_string(b, field[0], field[1]-1 - field[0]);
+  b->chromosome[i] = intern_string(b, field[5], field[6]-1 - field[5]);
+  b->position[i] = position;
+  b->length[i] = length;
+  b->totalReadLength[i] = total;
+  b->flags[i] = (*field[1] == 'R' ? RSW_BINARY_RIGHT_SIDE : 0) |
+                (*field[4] == '-' ? RSW_BINARY_MINUS_STRAND : 0);
+  b->numRecords++;
+  if (++b->blockRecords == BLOCK_RECORDS && !flush_binary_block(b)) {
+    fprintf(stderr, "Could not write binary output. aborting\n");
+    exit(1);
+  }
+  return 1;
+}
+
+/* append all of the temporary file from to out */
+int append_file(FILE *from, FILE *out) {
+  char buf[1 << 16];
+  size_t n;
+  if (fflush(from) != 0 || fseek(from, 0, SEEK_SET) != 0) return 0;
+  while ((n = fread(buf, 1, sizeof(buf), from)) > 0)
+    if (fwrite(buf, 1, n, out) != n) return 0;
+  return !ferror(from);
+}
+
+/*
+ finish the file in the order given in RSW_binary.h: the rest of the columns,
+ then the strings, then go back and fill in the header.
+ */
+int finish_binary(struct binary_out *b) {
+  struct RSW_binaryHeader h;
+  int i;
+  if (!flush_binary_block(b)) return 0;
+  for (i = 0; i < TEMP_COLUMNS; i++)
+    if (!append_file(b->columnFile[i], b->out)) return 0;
+  if (fwrite(b->strings, 1, b->stringBytes, b->out) != b->stringBytes) return 0;
+
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, RSW_BINARY_MAGIC, sizeof(h.magic));
+  h.numRecords = b->numRecords;
+  h.numStrings = b->numStrings;
+  h.stringBytes = b->stringBytes;
+  return fseek(b->out, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, b->out) == 1;
+}
+
+void free_binary(struct binary_out *b) {
+  int i;
+  for (i = 0; i < TEMP_COLUMNS; i++)
+    if (b->columnFile[i]) fclose(b->columnFile[i]);
+  free(b->id); free(b->chromosome); free(b->position);
+  free(b->length); free(b->totalReadLength); free(b->flags);
+  free(b->strings); free(b->stringStart); free(b->slots);
+}
+
+/*
+ read a line (including the newline) into *line, which grows as needed.
+ return 0 at end of file.  zlib reads plain files as they are.
+ */
+int read_line(char **line, size_t *n, gzFile in) {
+  size_t len = 0;
+  if (*n < 256) {
+    *n = 256;
+    *line = (char *)xrealloc(*line, *n);
+  }
+  while (gzgets(in, *line + len, *n - len)) {
+    len += strlen(*line + len);
+    if ((*line)[len-1] == '\n' || len + 1 < *n) return 1;
+    *n *= 2;
+    *line = (char *)xrealloc(*line, *n);
+  }
+  return len > 0;
+}
+
+void parse(char *filename, int binary, int compress) {
   char *line = 0;
   char *readName,*tmp;
-  size_t n;
+  size_t n = 0;
   int pos;
-  FILE *in, *out;
+  gzFile in, zout = NULL;
+  FILE *out = NULL;
   char *outname;
 
   
-  if (!(in = fopen(filename,"r"))) {
+  if (!(in = gzopen(filename,"r"))) {
     fprintf(stderr, "Could not open %s for reading", filename);
     perror("");
     return;
@@ -88,42 +346,94 @@ void parse(char *filename) {
   // bug fixed on Oct 27, 2015 where malloc was not allocating room for the NULL byte
   // at the end of the string. this caused the filename to be wrong sometimes, causing
   // the pipeline to fail sometimes.
-  outname = (char *)malloc(sizeof(char) * (strlen(filename)+strlen(SUFFIX)+1));
-  memset(outname, 0, sizeof(char) * (strlen(filename)+strlen(SUFFIX)+1));
-  sprintf(outname, "%s%s",filename,SUFFIX);
-  outname[strlen(filename)+strlen(SUFFIX)] = 0;
-  if (!(out = fopen(outname, "w"))) {
+  const char *outSuffix = binary ? RSW_BINARY_SUFFIX : compress ? GZ_SUFFIX : "";
+  size_t inlen = strlen(filename);
+  if (inlen > 3 && strcmp(filename+inlen-3, GZ_SUFFIX) == 0) inlen -= 3;
+  size_t outlen = inlen+strlen(SUFFIX)+strlen(outSuffix);
+  outname = (char *)malloc(sizeof(char) * (outlen+1));
+  memset(outname, 0, sizeof(char) * (outlen+1));
+  sprintf(outname, "%.*s%s%s",(int)inlen,filename,SUFFIX,outSuffix);
+  outname[outlen] = 0;
+  if (!binary && compress) zout = gzopen(outname, "wb1");
+  else out = fopen(outname, "w");
+  if (!out && !zout) {
     fprintf(stderr,"Could not open %s for writing", outname);
     perror("");
-    fclose(in);
+    gzclose(in);
     return;
   }
 
+  struct binary_out b;
+  memset(&b, 0, sizeof(b));
+  if (binary && !start_binary(&b, out, outname)) {
+    free_binary(&b);
+    fclose(out);
+    gzclose(in);
+    return;
+  }
+
+  struct rsf_stats stats;
+  rsf_stats_begin(&stats, "sfc", "format");
+
   tmp = 0;
-  while((!feof(in)) && (getline(&line,&n,in) != -1)) {
+  while(read_line(&line,&n,in)) {
+    stats.records++;
     if (tmp) { free(tmp); tmp=0; }
     tmp = strdup(line);
     char *found = strchr(line, '\t');
     pos = (found - line);
     split_field(tmp, pos);
-    fputs(tmp,out);
+    if (binary) {
+      if (!add_binary_line(&b, tmp)) {
+        fprintf(stderr, "Not enough fields in line, ignoring it and the rest of %s: %s", filename, tmp);
+        stats.records--;
+        break;
+      }
+    }
+    else if (zout) gzputs(zout,tmp);
+    else fputs(tmp,out);
+  }
+
+  if (binary) {
+    if (!finish_binary(&b)) {
+      fprintf(stderr,"Could not write to %s", outname);
+      perror("");
+    }
+    free_binary(&b);
   }
 
-  fclose(in);
-  fclose(out);
+  gzclose(in);
+  if (zout) {
+    if (gzclose(zout) != Z_OK) fprintf(stderr,"Could not write to %s\n", outname);
+  }
+  else fclose(out);
+
+  stats.bytesIn = rsf_stats_file_size(filename);
+  stats.bytesOut = rsf_stats_file_size(outname);
+  rsf_stats_end(&stats);
+  free(outname);
 }
 
 
 int main(int argc, char *argv[]) {
-  int i;
+  int i, binary = 0, compress = 0;
+
+  while (argc > 1 && (strcmp(argv[1], "-b") == 0 || strcmp(argv[1], "-z") == 0)) {
+    if (argv[1][1] == 'b') binary = 1;
+    else compress = 1;
+    argv++; argc--;
+  }
 
   if (argc < 2) {
-    fprintf(stderr, "usage -- %s <file to split> [additonal files...]\n",argv[0]);
+    fprintf(stderr, "usage -- %s [-b] [-z] <file to split> [additonal files...]\n",argv[0]);
+    fprintf(stderr, "  files to split may be gzip-compressed\n");
+    fprintf(stderr, "  -b  write binary %s%s files for splitPairs, instead of text\n", SUFFIX, RSW_BINARY_SUFFIX);
+    fprintf(stderr, "  -z  write gzip-compressed text %s%s files (not with -b, which splitPairs reads in place)\n", SUFFIX, GZ_SUFFIX);
     return 1;
   }
 
   for (i = 1;i < argc;i++)
-    parse(argv[i]);
+    parse(argv[i], binary, compress);
 
   return 0;
 }
@@ -3,92 +3,465 @@
 #include <string.h>
 #include <time.h>
 #include <libgen.h>
+#include <pthread.h>
+#include <zlib.h>
+
+#include "rsf_stats.h"
 
 const unsigned int K = 1024;
 int MIN_SPLIT_LENGTH;
 const char *SUFFIX = ".split";
+const char *GZ_SUFFIX = ".gz";
+
+/*
+ Output is collected in a large buffer and written with fwrite when it fills,
+ rather than with one fprintf per line - srr writes many lines for each read
+ so formatting the output is most of its work.
+ */
+#define OUT_BUF_SIZE (4 * K * K)
+
+struct out_buf {
+    char *buf;
+    size_t used, cap;
+    FILE *f;
+    struct out_buf *z;  // with -z, where buf is compressed to before writing
+};
+
+/*
+ With -z the output is gzip-compressed as a series of independent gzip
+ members, one for each buffer (or chunk, with -p) written, rather than as
+ one stream.  That way each worker thread compresses its own chunks.
+ gunzip, zcat and zlib (so bowtie) read the members as one file.
+ */
+void out_reserve(struct out_buf *o, size_t need);
+
+// replace the contents of z with src[0..len-1] compressed as a gzip member
+void gzip_member(const char *src, size_t len, struct out_buf *z) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "Unable to start compressing split reads. aborting\n");
+        exit(1);
+    }
+    size_t bound = deflateBound(&zs, len);
+    z->used = 0;
+    out_reserve(z, bound);
+    zs.next_in = (Bytef *)src; zs.avail_in = len;
+    zs.next_out = (Bytef *)z->buf; zs.avail_out = bound;
+    if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+        fprintf(stderr, "Error compressing split reads. aborting\n");
+        exit(1);
+    }
+    z->used = bound - zs.avail_out;
+    deflateEnd(&zs);
+}
+
+long long bytesWritten = 0; // for $RSF_STATS_FILE, see rsf_stats.h
+
+void write_out(const char *buf, size_t len, FILE *f) {
+    if (len > 0 && fwrite(buf, 1, len, f) != len) {
+        perror("Error writing split reads");
+        exit(1);
+    }
+    bytesWritten += len;
+}
+
+void out_flush(struct out_buf *o) {
+    if (o->used == 0) return;
+    if (o->z) {
+        gzip_member(o->buf, o->used, o->z);
+        write_out(o->z->buf, o->z->used, o->f);
+    }
+    else write_out(o->buf, o->used, o->f);
+    o->used = 0;
+}
+
+// make sure there is room for need more bytes.  if o has no file it grows
+// instead of being written out.
+void out_reserve(struct out_buf *o, size_t need) {
+    if (o->used + need <= o->cap) return;
+    if (o->f) out_flush(o);
+    if (o->used + need > o->cap) {
+        o->cap = o->used + need > 2 * o->cap ? o->used + need : 2 * o->cap;
+        if (!(o->buf = (char *)realloc(o->buf, o->cap))) {
+            fprintf(stderr, "Out of memory. aborting\n");
+            exit(1);
+        }
+    }
+}
+
+// write the decimal digits of v (>= 0) at p, return where they end
+char *put_int(char *p, int v) {
+    char digits[12];
+    int nd = 0;
+    do { digits[nd++] = '0' + v % 10; v /= 10; } while (v > 0);
+    while (nd > 0) *p++ = digits[--nd];
+    return p;
+}
+
+// write name-<side>-<cut>-<readLength>\n at p, return where it ends
+char *put_name(char *p, const char *name, int nameLength, char side, int cut, const char *lengthStr, int lengthStrLen) {
+    memcpy(p, name, nameLength); p += nameLength;
+    *p++ = '-'; *p++ = side; *p++ = '-';
+    p = put_int(p, cut);
+    *p++ = '-';
+    memcpy(p, lengthStr, lengthStrLen); p += lengthStrLen;
+    *p++ = '\n';
+    return p;
+}
+
+// write the four fastq lines for one piece of the read at p, return where they end
+char *put_piece(char *p, const char *id, int idLength, const char *str, int strLength,
+                const char *seq, const char *score, char side, int cut, int pieceLength,
+                const char *lengthStr, int lengthStrLen) {
+    p = put_name(p, id, idLength, side, cut, lengthStr, lengthStrLen);
+    memcpy(p, seq, pieceLength); p += pieceLength; *p++ = '\n';
+    p = put_name(p, str, strLength, side, cut, lengthStr, lengthStrLen);
+    memcpy(p, score, pieceLength); p += pieceLength; *p++ = '\n';
+    return p;
+}
+
+/*
+ read a line into *line (which grows as needed), removing the newline.
+ return its length, or -1 at end of file.  The input is read through zlib,
+ which reads plain files as they are and gzip files uncompressed.
+ */
+long read_line(char **line, size_t *n, gzFile in) {
+    size_t len = 0;
+    if (*n < 256) {
+        *n = 256;
+        if (!(*line = (char *)realloc(*line, *n))) {
+            fprintf(stderr, "Out of memory. aborting\n");
+            exit(1);
+        }
+    }
+    while (gzgets(in, *line + len, *n - len)) {
+        len += strlen(*line + len);
+        if ((*line)[len-1] == '\n') {
+            (*line)[--len] = 0;
+            return len;
+        }
+        if (len + 1 < *n) return len; // last line, no newline
+        *n *= 2;
+        if (!(*line = (char *)realloc(*line, *n))) {
+            fprintf(stderr, "Out of memory. aborting\n");
+            exit(1);
+        }
+    }
+    return len > 0 ? (long)len : -1;
+}
+
+/*
+ Write all the split pieces of one read to o.  Adds the number of lines
+ written to *linesOut, and returns the number of split positions.
+ */
+long split_read(struct out_buf *o, const char *id, long idLength, const char *seq, long seqLength,
+                const char *str, long strLength, const char *score, long scoreLength, long *linesOut) {
+    const int readLength = seqLength;
+    int left_cut = MIN_SPLIT_LENGTH;
+    int right_cut = readLength - MIN_SPLIT_LENGTH; // Jeff, to handle different length sequences
+    long l = 0u;
+    char lengthStr[12];
+
+    if (scoreLength < readLength) { // pieces of score are copied along with seq
+        fprintf(stderr, "Quality line shorter than sequence for read %s. aborting\n", id);
+        exit(1);
+    }
+
+    int lengthStrLen = put_int(lengthStr, readLength) - lengthStr;
+    // the most one split position can write: 8 pieces of the read, each
+    // with its name line and 2 numbers
+    size_t maxBytes = 8 * ((idLength > strLength ? idLength : strLength) + readLength + 2 * 12 + 8);
+
+    while(left_cut <= right_cut) {
+        ++l;
+
+        // note: also now printing out the total length of the sequence, because that can vary from read to read for some datasets.
+        out_reserve(o, maxBytes);
+        char *p = o->buf + o->used;
+
+        //left
+        p = put_piece(p, id, idLength, str, strLength, seq, score, 'L', left_cut, left_cut, lengthStr, lengthStrLen);
+        //right
+        p = put_piece(p, id, idLength, str, strLength, seq+left_cut, score+left_cut, 'R', right_cut, right_cut, lengthStr, lengthStrLen);
+
+        //REVERSED!
+        //left
+        p = put_piece(p, id, idLength, str, strLength, seq, score, 'L', right_cut, right_cut, lengthStr, lengthStrLen);
+        //right
+        p = put_piece(p, id, idLength, str, strLength, seq+right_cut, score+right_cut, 'R', left_cut, left_cut, lengthStr, lengthStrLen);
+
+        o->used = p - o->buf;
+
+        //next
+        ++left_cut; --right_cut;
+        *linesOut += 16;
+    }
+    return l;
+}
 
-void parse(FILE *in, FILE *out) {
+/*
+ About how many bytes split_read writes for a read: for each split position,
+ four pieces that together have the read's bases and scores twice, and eight
+ name lines.
+ */
+size_t split_bytes(long idLength, long seqLength, long strLength) {
+    long positions = seqLength - 2 * MIN_SPLIT_LENGTH + 1;
+    long nameLength = (idLength > strLength ? idLength : strLength) + 2 * 12 + 4;
+    return positions > 0 ? positions * (4 * seqLength + 8 + 8 * nameLength) : 0;
+}
+
+// returns the number of lines read
+long parse(gzFile in, FILE *out, int compress) {
     //char id[K],seq[K],str[K],score[K], tmp[K];
-    char *id,*seq,*str,*score,tmp;
-    size_t n;
+    // line buffers are reused from one read to the next
+    char *id,*seq,*str,*score;
+    size_t nId = 0, nSeq = 0, nStr = 0, nScore = 0;
+    long idLength, seqLength, strLength, scoreLength;
     long i = 0u, k = 0u, l = 0u;
-    int j;
-    int left_cut, right_cut; 
+    struct out_buf o, z;
     id = seq = str = score = 0;
-    while(!feof(in)) {
-        left_cut = MIN_SPLIT_LENGTH, right_cut = left_cut;
 
-        if (getline(&id, &n, in) == -1) break;
-        if (id[strlen(id)-1]== '\n') id[strlen(id)-1] = 0;
-        if (getline(&seq, &n, in) == -1) break;
-        if (seq[strlen(seq)-1] == '\n') seq[strlen(seq)-1] = 0;
-        const int readLength = strlen(seq);
+    o.cap = OUT_BUF_SIZE; o.used = 0; o.f = out; o.z = compress ? &z : NULL;
+    z.buf = NULL; z.cap = z.used = 0; z.f = NULL; z.z = NULL;
+    if (!(o.buf = (char *)malloc(o.cap))) {
+        fprintf(stderr, "Out of memory. aborting\n");
+        exit(1);
+    }
 
-        right_cut = readLength - MIN_SPLIT_LENGTH; // Jeff, to handle different length sequences
+    while(!gzeof(in)) {
+        //must have all 4 to contnue...
+        if ((idLength = read_line(&id, &nId, in)) == -1) break;
+        if ((seqLength = read_line(&seq, &nSeq, in)) == -1) break;
+        if ((strLength = read_line(&str, &nStr, in)) == -1) break;
+        if ((scoreLength = read_line(&score, &nScore, in)) == -1) break;
 
-        if (getline(&str, &n, in) == -1) break;
-        if (str[strlen(str)-1] == '\n') str[strlen(str)-1] = 0;
+        k+=4;
+        l = split_read(&o, id, idLength, seq, seqLength, str, strLength, score, scoreLength, &i);
+    }
+    out_flush(&o);
+    free(o.buf); free(z.buf);
+    free(id); free(seq); free(str); free(score);
+    fprintf(stderr,"in: %lu, out: %lu, passes each line: %lu, total passes: %lu\n", k, i, l, l*k);
+    return k;
+}
 
-        if (getline(&score, &n, in) == -1) break;
-        if (score[strlen(score)-1] == '\n') score[strlen(score)-1] = 0;
+/*
+ Splitting with several threads (-p N).  The main thread reads the input in
+ chunks, worker threads split the chunks into their own output buffers (and
+ compress them, with -z), and a writer thread writes the buffers out, in the
+ same order as the input unless --unordered.  There are a fixed number of
+ chunks which are reused, so memory use does not grow with the input.
 
-        k+=4;
-        l = 0u;
-        //must have all 4 to contnue...
-        while(left_cut <= right_cut) {
-            ++l;
-
-            // note: also now printing out the total length of the sequence, because that can vary from read to read for some datasets.
-    
-            //left
-            fprintf(out, "%s-L-%d-%d\n",id,left_cut,readLength);
-            fprintf(out, "%.*s\n",left_cut,seq);
-            fprintf(out, "%s-L-%d-%d\n",str,left_cut,readLength);
-            fprintf(out, "%.*s\n",left_cut,score);
-    
-            //right
-            fprintf(out, "%s-R-%d-%d\n",id,right_cut,readLength);
-            fprintf(out, "%.*s\n",right_cut,seq+left_cut);
-            fprintf(out, "%s-R-%d-%d\n",str,right_cut,readLength);
-            fprintf(out, "%.*s\n",right_cut,score+left_cut);
-
-            //REVERSED!
-            //left
-            fprintf(out, "%s-L-%d-%d\n",id,right_cut,readLength);
-            fprintf(out, "%.*s\n",right_cut,seq);
-            fprintf(out, "%s-L-%d-%d\n",str,right_cut,readLength);
-            fprintf(out, "%.*s\n",right_cut, score);
- 
-            //right
-            fprintf(out, "%s-R-%d-%d\n",id,left_cut,readLength);
-            fprintf(out, "%.*s\n",left_cut,seq+right_cut);
-            fprintf(out, "%s-R-%d-%d\n",str,left_cut,readLength);
-            fprintf(out, "%.*s\n",left_cut,score+right_cut);
-
-            //next
-            ++left_cut; --right_cut;
-            i+=16;
+ Each read becomes many times its size once split, so a chunk ends when its
+ reads will make about CHUNK_BYTES of output (see split_bytes), or at
+ CHUNK_READS reads.  That keeps the output buffers of all the chunks to a
+ few MB per thread.
+ */
+#define CHUNK_READS 256
+#define CHUNK_BYTES (1 * K * K)
+
+enum chunk_state { CHUNK_FREE, CHUNK_READ, CHUNK_WORKING, CHUNK_DONE, CHUNK_WRITING };
+
+struct chunk {
+    char *line[4*CHUNK_READS];  // line buffers are reused from one chunk to the next
+    size_t n[4*CHUNK_READS];
+    long len[4*CHUNK_READS];
+    int numReads;
+    long seq;                   // which chunk of the input this is
+    enum chunk_state state;
+    struct out_buf o, z;        // z is o compressed, with -z
+    long linesOut, passes;      // for the summary at the end
+};
+
+struct chunk_queue {
+    struct chunk *chunks;
+    int numChunks;
+    long numRead;               // chunks 0 .. numRead-1 have been read
+    long nextToSplit, numWritten;
+    int doneReading, unordered, compress;
+    FILE *out;
+    long linesOut, passes;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;     // signalled whenever a chunk changes state
+};
+
+void *split_worker(void *arg) {
+    struct chunk_queue *q = (struct chunk_queue *)arg;
+    pthread_mutex_lock(&q->lock);
+    while (1) {
+        while (q->nextToSplit >= q->numRead && !q->doneReading)
+            pthread_cond_wait(&q->changed, &q->lock);
+        if (q->nextToSplit >= q->numRead) break;
+
+        struct chunk *c = &q->chunks[q->nextToSplit++ % q->numChunks];
+        c->state = CHUNK_WORKING;
+        pthread_mutex_unlock(&q->lock);
+
+        int r;
+        c->o.used = 0; c->linesOut = 0;
+        for (r = 0; r < c->numReads; r++) {
+            char **line = c->line + 4*r;
+            long *len = c->len + 4*r;
+            c->passes = split_read(&c->o, line[0], len[0], line[1], len[1], line[2], len[2], line[3], len[3], &c->linesOut);
         }
-        free(id); id = 0;
-        free(seq); seq = 0;
-        free(str); str = 0;
-        free(score); score = 0;
+        if (q->compress && c->o.used > 0) gzip_member(c->o.buf, c->o.used, &c->z);
+
+        pthread_mutex_lock(&q->lock);
+        c->state = CHUNK_DONE;
+        pthread_cond_broadcast(&q->changed);
     }
-    fprintf(stderr,"in: %lu, out: %lu, passes each line: %lu, total passes: %lu\n", k, i, l, l*k);
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+void *split_writer(void *arg) {
+    struct chunk_queue *q = (struct chunk_queue *)arg;
+    pthread_mutex_lock(&q->lock);
+    while (1) {
+        // the next chunk to write - the next one in order, or any that is done
+        struct chunk *c = NULL;
+        while (1) {
+            if (q->unordered) {
+                int j;
+                for (j = 0; j < q->numChunks && !c; j++)
+                    if (q->chunks[j].state == CHUNK_DONE) c = &q->chunks[j];
+            }
+            else {
+                struct chunk *next = &q->chunks[q->numWritten % q->numChunks];
+                if (next->state == CHUNK_DONE && next->seq == q->numWritten) c = next;
+            }
+            if (c || (q->doneReading && q->numWritten >= q->numRead)) break;
+            pthread_cond_wait(&q->changed, &q->lock);
+        }
+        if (!c) break;
+        c->state = CHUNK_WRITING;
+        pthread_mutex_unlock(&q->lock);
+
+        if (q->compress) {
+            if (c->o.used > 0) write_out(c->z.buf, c->z.used, q->out);
+        }
+        else write_out(c->o.buf, c->o.used, q->out);
+
+        pthread_mutex_lock(&q->lock);
+        q->linesOut += c->linesOut;
+        if (c->numReads > 0) q->passes = c->passes;
+        q->numWritten++;
+        c->state = CHUNK_FREE;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+// returns the number of lines read
+long parse_parallel(gzFile in, FILE *out, int numThreads, int unordered, int compress) {
+    struct chunk_queue q;
+    pthread_t *workers = (pthread_t *)malloc(sizeof(pthread_t) * numThreads);
+    pthread_t writer;
+    long k = 0u;
+    int t;
+
+    memset(&q, 0, sizeof(q));
+    q.numChunks = 2 * numThreads + 2;
+    q.chunks = (struct chunk *)calloc(q.numChunks, sizeof(struct chunk));
+    if (!workers || !q.chunks) {
+        fprintf(stderr, "Out of memory. aborting\n");
+        exit(1);
+    }
+    q.unordered = unordered;
+    q.compress = compress;
+    q.out = out;
+    pthread_mutex_init(&q.lock, NULL);
+    pthread_cond_init(&q.changed, NULL);
+
+    for (t = 0; t < numThreads; t++) pthread_create(&workers[t], NULL, split_worker, &q);
+    pthread_create(&writer, NULL, split_writer, &q);
+
+    long seq;
+    for (seq = 0; ; seq++) {
+        struct chunk *c = &q.chunks[seq % q.numChunks];
+        pthread_mutex_lock(&q.lock);
+        while (c->state != CHUNK_FREE) pthread_cond_wait(&q.changed, &q.lock);
+        pthread_mutex_unlock(&q.lock);
+
+        // the chunk is free, so only this thread uses it until it is marked read
+        int eof = 0;
+        size_t bytes = 0;
+        c->numReads = 0;
+        while (c->numReads < CHUNK_READS && bytes < CHUNK_BYTES && !eof) {
+            int j, r = c->numReads;
+            //must have all 4 to contnue...
+            for (j = 0; j < 4 && !eof; j++)
+                eof = (c->len[4*r+j] = read_line(&c->line[4*r+j], &c->n[4*r+j], in)) == -1;
+            if (!eof) {
+                bytes += split_bytes(c->len[4*r], c->len[4*r+1], c->len[4*r+2]);
+                c->numReads++;
+            }
+        }
+        k += 4 * c->numReads;
+        if (c->numReads == 0) break;
+
+        pthread_mutex_lock(&q.lock);
+        c->seq = seq;
+        c->state = CHUNK_READ;
+        q.numRead = seq+1;
+        pthread_cond_broadcast(&q.changed);
+        pthread_mutex_unlock(&q.lock);
+        if (eof) break;
+    }
+
+    pthread_mutex_lock(&q.lock);
+    q.doneReading = 1;
+    pthread_cond_broadcast(&q.changed);
+    pthread_mutex_unlock(&q.lock);
+
+    for (t = 0; t < numThreads; t++) pthread_join(workers[t], NULL);
+    pthread_join(writer, NULL);
+
+    for (t = 0; t < q.numChunks; t++) {
+        int j;
+        for (j = 0; j < 4*CHUNK_READS; j++) free(q.chunks[t].line[j]);
+        free(q.chunks[t].o.buf);
+        free(q.chunks[t].z.buf);
+    }
+    free(q.chunks);
+    free(workers);
+    pthread_mutex_destroy(&q.lock);
+    pthread_cond_destroy(&q.changed);
+    fprintf(stderr,"in: %lu, out: %lu, passes each line: %lu, total passes: %lu\n", k, q.linesOut, q.passes, q.passes*k);
+    return k;
 }
 
 int main(int argc, char *argv[]) {
+    // -p N, -z, --unordered and --stdout can be anywhere, take them out of argv
+    int numThreads = 1, unordered = 0, toStdout = 0, compress = 0, a, numArgs = 1;
+    for (a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-p") == 0 && a+1 < argc) numThreads = atoi(argv[++a]);
+        else if (strcmp(argv[a], "-z") == 0) compress = 1;
+        else if (strcmp(argv[a], "--unordered") == 0) unordered = 1;
+        else if (strcmp(argv[a], "--stdout") == 0) toStdout = 1;
+        else argv[numArgs++] = argv[a];
+    }
+    argc = numArgs;
+    if (numThreads < 1) numThreads = 1;
+
     if (argc < 3) {
-        fprintf(stderr,"Usage; %s <file> <min size>\n",argv[0]);
+        fprintf(stderr,"Usage; %s <file> <min size> [output directory] [-p threads] [-z] [--unordered] [--stdout]\n",argv[0]);
+        fprintf(stderr,"  <file> may be gzip-compressed\n");
+        fprintf(stderr,"  -z        gzip the split reads, written to <file>%s%s\n", SUFFIX, GZ_SUFFIX);
+        fprintf(stderr,"  --stdout  write the split reads to stdout (e.g. piped into bowtie) instead of a file\n");
         return 1;
     }
-    clock();
-    clock_t after, before;
-    before = clock();
-    FILE *fr, *fw;
+    // wall clock time, since with -p the cpu time is more than the time taken
+    struct timespec after, before;
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    struct rsf_stats stats;
+    rsf_stats_begin(&stats, "srr", "split");
+    gzFile fr;
+    FILE *fw;
     char *newfn, *name;
-    int sp = 0, sn, ss = strlen(SUFFIX);
+    int sp = 0, sn, ss = strlen(SUFFIX) + strlen(GZ_SUFFIX);
     char flag = 0;
     if (argc >= 4) {
         sp = strlen(argv[3]);
@@ -98,31 +471,45 @@ int main(int argc, char *argv[]) {
         name = argv[1];
     }
     sn = strlen(name);
+    // name.gz is split into name.split(.gz)
+    if (sn > 3 && strcmp(name + sn - 3, GZ_SUFFIX) == 0) sn -= 3;
     newfn = (char *)malloc(sizeof(char) * (sp+1+sn+ss+1)); // bug fix 6 jan 2016, added +1 to include space for terminating NULL character.  and 28 may 2016, another +1 for "/"
     memset(newfn,0,sizeof(char)*(sp+1+sn+ss+1)); // bug fix 6 jan 2016, added +1 to include space for terminating NULL character
     if (sp) strcpy(newfn,argv[3]);
     if (sp && !flag) strcat(newfn,"/");
-    newfn = strcat(strcat(newfn, name),SUFFIX);
+    newfn = strcat(strncat(newfn, name, sn),SUFFIX);
+    if (compress) strcat(newfn, GZ_SUFFIX);
 
     MIN_SPLIT_LENGTH = atoi(argv[2]);
 
-    if (!(fr = fopen(argv[1], "r"))) {
+    if (!(fr = gzopen(argv[1], "r"))) {
         fprintf(stderr,"Unable to open %s for reading.  ", argv[1]);
         perror("");
         return 1;
     }
 
-    if (!(fw = fopen(newfn, "w"))) {
+    if (toStdout) fw = stdout;
+    else if (!(fw = fopen(newfn, "w"))) {
         fprintf(stderr,"Unable to open %s for reading.  ", argv[1]);
         perror("");
-        fclose(fr);
+        gzclose(fr);
+        return 1;
+    }
+    gzbuffer(fr, 256 * K);
+
+    long linesIn;
+    if (numThreads > 1) linesIn = parse_parallel(fr, fw, numThreads, unordered, compress);
+    else linesIn = parse(fr,fw,compress);
+    gzclose(fr);
+    if (fclose(fw) != 0) {
+        perror("Error writing split reads");
         return 1;
     }
-    
-    parse(fr,fw);
-    fclose(fr);
-    fclose(fw);
-    after = clock();
-    fprintf(stderr,"time elapsed: %lf seconds.\n",(after-before)*(1.0/CLOCKS_PER_SEC));
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    fprintf(stderr,"time elapsed: %lf seconds.\n",(after.tv_sec-before.tv_sec) + (after.tv_nsec-before.tv_nsec)*1e-9);
+    stats.bytesIn = rsf_stats_file_size(argv[1]);
+    stats.bytesOut = bytesWritten;
+    stats.records = linesIn / 4; // reads
+    rsf_stats_end(&stats);
     return 0;
 }
@@ -0,0 +1,50 @@
+#! /usr/bin/env python
+# Put together the statistics written to $RSF_STATS_FILE by the RSF programs
+# and pipeline.sh (one JSON object per line, see src/rsf_stats.h) into one
+# JSON report for the run: every phase in the order it finished, and totals
+# for each program.
+from __future__ import print_function
+
+import json
+import sys
+
+if __name__ == "__main__":
+  if len(sys.argv) != 2:
+    print('usage: stats_report.py statsFile')
+    sys.exit(-1)
+
+  phases = []
+  with open(sys.argv[1]) as f:
+    for line in f:
+      line = line.strip()
+      if line:
+        phases.append(json.loads(line))
+
+  programs = {}
+  wall = None
+  for p in phases:
+    if p["phase"] == "total":
+      # whole run of a program (or of the pipeline), already counted by its phases
+      if p["program"] == "pipeline.sh":
+        wall = p["wall_sec"]
+      continue
+    t = programs.setdefault(p["program"], {"wall_sec": 0.0, "cpu_sec": 0.0,
+                                           "peak_rss_kb": 0, "bytes_in": 0,
+                                           "bytes_out": 0, "pids": set()})
+    t["wall_sec"] += p.get("wall_sec", 0.0)
+    t["cpu_sec"] += p.get("cpu_sec", 0.0)
+    t["peak_rss_kb"] = max(t["peak_rss_kb"], p.get("peak_rss_kb", 0))
+    t["bytes_in"] += p.get("bytes_in", 0)
+    t["bytes_out"] += p.get("bytes_out", 0)
+    if "pid" in p:
+      t["pids"].add(p["pid"])
+
+  for name in programs:
+    t = programs[name]
+    t["runs"] = len(t.pop("pids"))
+    t["wall_sec"] = round(t["wall_sec"], 3)
+    t["cpu_sec"] = round(t["cpu_sec"], 3)
+
+  report = {"wall_sec": wall, "programs": programs, "phases": phases}
+  print(json.dumps(report, indent=2, sort_keys=True))
+  sys.exit(0)
@@ -0,0 +1,120 @@
+/*
+  File:        bench_sort.cpp
+
+  Contents:    Benchmark of sorting the read data the way splitPairs does.
+               Makes N random packed RSW records (about 20 pieces per read
+               id, 25 chromosomes) and times, for both sort orders:
+
+                 std::sort with the comparators from before the packed keys
+                 stable_sort with the packed key comparators (RSW.h)
+                 parallel_sort with the packed key comparators, 1/2/4/8 threads
+
+               Each parallel_sort result is checked against stable_sort's.
+               Built and run by test/run_bench.sh.
+
+  To run:      ./bench_sort [N]        N records, default 10000000
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include "../src/RSW.h"
+#include "../src/parallel_sort.h"
+
+using namespace std;
+
+int numThreads = 1;
+
+// the comparators as they were before the packed keys
+bool old_compare_dataById(RSW const &aa, RSW const &bb) {
+  if (aa.id < bb.id) return true;
+  else if (aa.id > bb.id) return false;
+
+  if (aa.direction() < bb.direction())
+    return true;
+  else if (bb.direction() < aa.direction())
+    return false;
+
+  if (aa.chromosome < bb.chromosome) return true;
+  else if (aa.chromosome > bb.chromosome) return false;
+
+  if (aa.position < bb.position) return true;
+  else return false;
+}
+
+bool old_compare_dataByChromPos(RSW const &aa, RSW const &bb) {
+  if (aa.chromosome < bb.chromosome) return true;
+  else if (aa.chromosome > bb.chromosome) return false;
+
+  if (aa.splitPos() < bb.splitPos()) return true;
+  else if (aa.splitPos() > bb.splitPos()) return false;
+
+  return false;
+}
+
+vector<RSW> records;
+
+bool same_record(RSW const &a, RSW const &b) {
+  return a.id == b.id && a.chromosome == b.chromosome && a.position == b.position &&
+    a.length == b.length && a.rightSide == b.rightSide && a.minusStrand == b.minusStrand;
+}
+
+// time one sort of a copy of records, print a line and return the sorted copy
+template<class Sort>
+vector<RSW> time_sort(const char *order, const char *how, Sort sort) {
+  vector<RSW> v(records);
+  auto start = chrono::steady_clock::now();
+  sort(v);
+  double sec = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  printf("%-12s %-38s %8.3f sec %8.2f M records/sec\n", order, how, sec, records.size() / sec / 1e6);
+  fflush(stdout);
+  return v;
+}
+
+void bench(const char *order, bool (*oldCompare)(RSW const &, RSW const &),
+           bool (*compare)(RSW const &, RSW const &)) {
+  time_sort(order, "std::sort, old comparator", [&](vector<RSW> &v) {
+      sort(v.begin(), v.end(), oldCompare);
+    });
+  vector<RSW> expected = time_sort(order, "stable_sort, packed keys", [&](vector<RSW> &v) {
+      stable_sort(v.begin(), v.end(), compare);
+    });
+
+  int threads[] = { 1, 2, 4, 8 };
+  for(int t : threads) {
+    char how[100];
+    snprintf(how, sizeof(how), "parallel_sort, packed keys, %i thread%s", t, t > 1 ? "s" : "");
+    numThreads = t;
+    vector<RSW> v = time_sort(order, how, [&](vector<RSW> &v) {
+        parallel_sort(v.begin(), v.end(), compare);
+      });
+    if (! equal(v.begin(), v.end(), expected.begin(), same_record)) {
+      printf("ERROR, parallel_sort with %i threads differs from stable_sort.\n", t);
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  size_t n = argc > 1 ? atol(argv[1]) : 10000000;
+
+  mt19937_64 random(1);
+  records.resize(n);
+  for(size_t i=0; i < n; i++) {
+    RSW &r = records[i];
+    r.id = random() % (n / 20 + 1);
+    r.chromosome = random() % 25;
+    r.position = random() % 250000000;
+    r.length = 20 + random() % 60;
+    r.totalReadLength = 100;
+    r.rightSide = random() & 1;
+    r.minusStrand = random() & 1;
+    r.otherHalfMaxLength = 0;
+  }
+  printf("sorting %zu records of %zu bytes, %u cores\n", n, sizeof(RSW), thread::hardware_concurrency());
+
+  bench("by id", old_compare_dataById, compare_dataById);
+  bench("by position", old_compare_dataByChromPos, compare_dataByChromPos);
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*
+  File:        part_starts_test.cpp
+
+  Contents:    Checks part_starts (RSW.h), which splitPairs uses to split the
+               read data into parts for its threads, on sizes past 2^31 and
+               2^32 records, where int indexes would overflow.  No data is
+               made, only the indexes are checked.  Built and run by
+               test/run_tests.sh.
+*/
+
+#include <stdio.h>
+#include "../src/RSW.h"
+
+using namespace std;
+
+int failed = 0;
+
+void check(bool ok, const char *what, size_t n, int numParts) {
+  if (ok) return;
+  printf("FAIL part_starts: %s, n=%zu numParts=%i\n", what, n, numParts);
+  failed = 1;
+}
+
+// starts must begin at 0, end with n, increase, and not split a group
+void check_starts(const vector<size_t> &starts, size_t n, int numParts,
+                  function<bool(size_t)> sameGroup) {
+  check(starts.size() >= 2 && starts.size() <= (size_t) numParts + 1, "number of parts", n, numParts);
+  check(starts.front() == 0 && starts.back() == n, "first or last start", n, numParts);
+  for(size_t i=1; i+1 < starts.size(); i++) {
+    check(starts[i] > starts[i-1], "starts do not increase", n, numParts);
+    check(! sameGroup(starts[i]), "part starts inside a group", n, numParts);
+  }
+}
+
+int main() {
+  size_t sizes[] = { 0, 3, 1000, (size_t) 1 << 31, ((size_t) 1 << 32) + 7, 200000000000UL };
+  int parts[] = { 1, 8, 64, 256 };
+  auto never = [](size_t) { return false; };
+
+  for(size_t n : sizes) {
+    for(int numParts : parts) {
+      // no groups: the parts are all the same size, as n*p/numParts
+      vector<size_t> starts = part_starts(n, numParts, never);
+      check_starts(starts, n, numParts, never);
+      if (n >= (size_t) numParts) {
+        check(starts.size() == (size_t) numParts + 1, "parts missing", n, numParts);
+        for(int p=0; p < numParts; p++)
+          check(starts[p] == n * p / numParts, "start is not n*p/numParts", n, numParts);
+      }
+
+      // groups of 1000 records (like the records of one read id)
+      auto inGroup = [](size_t i) { return i % 1000 != 0; };
+      check_starts(part_starts(n, numParts, inGroup), n, numParts, inGroup);
+    }
+  }
+
+  if (failed) return 1;
+  printf("ok   part_starts\n");
+  return 0;
+}
@@ -0,0 +1,168 @@
+#!/bin/bash
+# Benchmarks, run from the top directory with "make bench".  These only
+# print timings, nothing is checked against expected numbers; the machine
+# and the number of cores are printed so runs can be compared.
+#
+#   test/run_bench.sh              run all the benchmarks
+#   test/run_bench.sh sort         run one of them: sort, read or srr
+#
+# Sizes can be changed with environment variables:
+#   BENCH_SORT_RECORDS   records to sort (default 10000000)
+#   BENCH_READ_LINES     lines of read data for sp4 to read (default 20000000,
+#                        about 1.4GB of .split1stcolumn; the files are made in
+#                        a temporary directory under $TMPDIR)
+#   BENCH_BASELINE_REV   git revision of the sp4 and srr to compare against (default the first commit, before the
+#                        memory-mapped parser); set to "none" to skip it
+#   BENCH_BASELINE_LINES lines for the baseline sp4 (default 2000000; it uses
+#                        about 550 bytes of memory per line)
+#   BENCH_SRR_READS      reads in the FASTQ file for srr (default 10000000)
+#   BENCH_SRR_LENGTH     length of the reads (default 100)
+#   BENCH_SRR_MIN        minimum split length given to srr (default 20)
+#   BENCH_SRR_THREADS    -p for the multi-threaded run (default the number of
+#                        cores, at least 2)
+#   BENCH_SRR_BASELINE_READS  reads for the baseline srr (default 500000, it
+#                        is about 10 times slower)
+
+BASEDIR=$( cd ${0%/*}/.. >& /dev/null ; pwd -P )
+WHICH=${1:-all}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+echo "$(uname -n), $(nproc) cores, $(date)"
+
+# sorting the read data: std::sort with the old comparators against
+# parallel_sort with the packed keys, see test/bench_sort.cpp
+if [ "$WHICH" == "all" ] || [ "$WHICH" == "sort" ]; then
+    echo
+    echo "== sort"
+    g++ -O4 -std=c++11 -pthread -o bench_sort "$BASEDIR/test/bench_sort.cpp" || exit 1
+    ./bench_sort ${BENCH_SORT_RECORDS:-10000000} || exit 1
+fi
+
+# reading the read data: sp4's read_data on the same reads as plain text
+# (memory-mapped), gzip-compressed text, raw bowtie output, and sfc -b's binary
+# format, and the text with the baseline sp4 (reading a line at a time).
+# The data is made so finding junctions is quick, but sp4 still sorts it.
+if [ "$WHICH" == "all" ] || [ "$WHICH" == "read" ]; then
+    echo
+    echo "== read"
+    for prog in sp4 sfc; do
+        if [ ! -x "$BASEDIR/$prog" ]; then echo "$BASEDIR/$prog not built, run make bench" >&2; exit 1; fi
+    done
+    lines=${BENCH_READ_LINES:-20000000}
+
+    # raw bowtie output, 4 pieces of 100bp reads, whose lengths do not add up
+    # to a read so there are no junctions
+    awk -v n=$lines 'BEGIN {
+        srand(1); seq = "ACGTACGTACGTACGTACGTACGTACGTAC"; qual = "IIIIIIIIIIIIIIIIIIIIIIIIIIIIII";
+        for (i = 0; i < n; i++) {
+            printf "D2FC08P1:143:D0KHCACXX:6:1101:%d:%d 1:N:0:-%s-30-100/%d\t%s\tchr%d\t%d\t%s\t%s\t0\t\n",
+                int(i/4), int(i/4)%1000, (i%2 ? "R" : "L"), 1+int(i/2)%2, (rand() < 0.5 ? "+" : "-"),
+                1+int(rand()*22), int(rand()*200000000), seq, qual
+        }
+    }' > data.bowtie.txt
+    "$BASEDIR/sfc" data.bowtie.txt > /dev/null
+    "$BASEDIR/sfc" -b data.bowtie.txt > /dev/null
+    mv data.bowtie.txt.split1stcolumn data.split1stcolumn
+    mv data.bowtie.txt.split1stcolumn.bin data.split1stcolumn.bin
+    gzip -1 -c data.split1stcolumn > data.split1stcolumn.gz
+    cp "$BASEDIR/test/sp4/refFlat.txt" "$BASEDIR/test/sp4/bound.txt" .
+
+    echo "$lines lines, baseline on the first ${BENCH_BASELINE_LINES:-2000000}"
+
+    # read_time sp4 data lines label: run sp4 on data and print how long reading it took
+    function read_time() {
+        local sp4=$1 data=$2 lines=$3 label=$4
+        printf '%s\n40000\n30\nrefFlat.txt\nbound.txt\n2\n5\n%s\n2\n' "$data" out > options.txt
+        "$sp4" options.txt > stdout.txt 2>&1 || { echo "$label: sp4 failed"; tail stdout.txt; return; }
+        # the current sp4 prints the read time; the baseline only whole seconds since it started
+        local sec=$(awk '/^Read .* lines of read data in/ { print $(NF-3) }' stdout.txt)
+        if [ -z "$sec" ]; then
+            sec=$(awk '/Done reading refFlat intron\/exon boundaries/ { b = $(NF-1) }
+                       /Done reading read data/ { print $(NF-1) - b }' stdout.txt)
+        fi
+        local mb=$(( $(stat -c %s "$data") / 1000000 ))
+        awk -v l="$label" -v mb=$mb -v s=$sec -v n=$lines 'BEGIN {
+            printf "%-40s %6d MB file %8.2f sec %8.2f M lines/sec\n", l, mb, s, n/(s>0?s:1e-9)/1e6 }'
+        rm -f out.*
+    }
+
+    read_time "$BASEDIR/sp4" data.split1stcolumn     $lines "text, memory-mapped"
+    read_time "$BASEDIR/sp4" data.split1stcolumn.gz  $lines "text, gzip"
+    read_time "$BASEDIR/sp4" data.bowtie.txt         $lines "raw bowtie output"
+    read_time "$BASEDIR/sp4" data.split1stcolumn.bin $lines "binary (sfc -b)"
+
+    rev=${BENCH_BASELINE_REV:-$(git -C "$BASEDIR" rev-list --max-parents=0 HEAD 2>/dev/null | tail -1)}
+    if [ "$rev" != "none" ] && [ -n "$rev" ]; then
+        mkdir -p baseline
+        if git -C "$BASEDIR" show $rev:src/splitPairs.cpp > baseline/splitPairs.cpp &&
+           git -C "$BASEDIR" show $rev:src/RSW.h > baseline/RSW.h &&
+           g++ -O4 -std=c++11 -w -o baseline/sp4 baseline/splitPairs.cpp -pthread -lz; then
+            baseLines=${BENCH_BASELINE_LINES:-2000000}
+            if (( baseLines > lines )); then baseLines=$lines; fi
+            head -n $baseLines data.split1stcolumn > first.split1stcolumn
+            read_time "$BASEDIR/sp4" first.split1stcolumn $baseLines "text, memory-mapped, first lines"
+            read_time baseline/sp4 first.split1stcolumn $baseLines "text, baseline $(git -C "$BASEDIR" rev-parse --short $rev), first lines"
+        else
+            echo "could not build the baseline sp4 from revision $rev"
+        fi
+    fi
+fi
+
+# splitting reads: srr on a generated FASTQ file with -p 1 and -p N.  The
+# output (many times the input) goes to /dev/null with --stdout, so it does
+# not need the disk space; its size is measured on the first 1000 reads.
+if [ "$WHICH" == "all" ] || [ "$WHICH" == "srr" ]; then
+    echo
+    echo "== srr"
+    if [ ! -x "$BASEDIR/srr" ]; then echo "$BASEDIR/srr not built, run make bench" >&2; exit 1; fi
+    reads=${BENCH_SRR_READS:-10000000}
+    length=${BENCH_SRR_LENGTH:-100}
+    min=${BENCH_SRR_MIN:-20}
+    threads=${BENCH_SRR_THREADS:-$(nproc)}
+    if (( threads < 2 )); then threads=2; fi
+
+    # reads are pieces of one long random sequence, so awk does not make each base
+    awk -v n=$reads -v len=$length 'BEGIN {
+        srand(3);
+        for (i = 0; i < 4096 + len; i++) pool = pool substr("ACGT", 1+int(rand()*4), 1);
+        for (i = 0; i < len; i++) qual = qual "I";
+        for (i = 0; i < n; i++)
+            printf "@D2FC08P1:143:D0KHCACXX:6:1101:%d:%d 1:N:0:\n%s\n+\n%s\n", i, i%1000,
+                substr(pool, 1+int(rand()*4096), len), qual
+    }' > reads.fq
+    head -n 4000 reads.fq > sample.fq
+    sampleBytes=$("$BASEDIR/srr" sample.fq $min --stdout 2> /dev/null | wc -c)
+    echo "$reads reads of ${length}bp, min split $min, $(( $(stat -c %s reads.fq) / 1000000 )) MB"
+
+    for p in 1 $threads; do
+        start=$(date +%s.%N)
+        "$BASEDIR/srr" reads.fq $min -p $p --stdout 2> srr.txt > /dev/null || { echo "srr -p $p failed"; cat srr.txt; continue; }
+        end=$(date +%s.%N)
+        awk -v p=$p -v s=$start -v e=$end -v n=$reads -v b=$sampleBytes 'BEGIN {
+            sec = e - s; out = n * b / 1000 / 1e9;
+            printf "%-30s %8.2f sec %10.0f reads/sec  about %.1f GB out, %.2f GB/sec\n", "srr -p " p, sec, n/sec, out, out/sec }'
+    done
+
+    # the baseline srr has no --stdout, so its output file is a link to /dev/null
+    rev=${BENCH_BASELINE_REV:-$(git -C "$BASEDIR" rev-list --max-parents=0 HEAD 2>/dev/null | tail -1)}
+    if [ "$rev" != "none" ] && [ -n "$rev" ]; then
+        mkdir -p baseline/out
+        if git -C "$BASEDIR" show $rev:src/split_read_rsw.c > baseline/split_read_rsw.c &&
+           gcc -O4 -w -o baseline/srr baseline/split_read_rsw.c -pthread -lz; then
+            baseReads=${BENCH_SRR_BASELINE_READS:-500000}
+            if (( baseReads > reads )); then baseReads=$reads; fi
+            head -n $(( 4 * baseReads )) reads.fq > first.fq
+            ln -sf /dev/null baseline/out/first.fq.split
+            start=$(date +%s.%N)
+            baseline/srr first.fq $min baseline/out 2> srr.txt > /dev/null || { echo "baseline srr failed"; cat srr.txt; }
+            end=$(date +%s.%N)
+            awk -v l="baseline $(git -C "$BASEDIR" rev-parse --short $rev), first reads" -v s=$start -v e=$end -v n=$baseReads 'BEGIN {
+                sec = e - s; printf "%-30s %8.2f sec %10.0f reads/sec\n", l, sec, n/sec }'
+        else
+            echo "could not build the baseline srr from revision $rev"
+        fi
+    fi
+fi
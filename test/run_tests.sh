@@ -0,0 +1,97 @@
+#!/bin/bash
+# Regression test for sp4 (src/splitPairs.cpp).  Runs sp4 on the small data set
+# in test/sp4 in each of the ways it can read its input and diffs the results
+# files against test/sp4/expected, and checks part_starts (src/RSW.h) with
+# test/part_starts_test.cpp.  Run from the top directory with "make test",
+# which builds sp4 and sfc first.
+#
+#   test/run_tests.sh            run the tests
+#   test/run_tests.sh --update   write the output of the first run to test/sp4/expected
+#                                (only when the output is meant to change)
+
+BASEDIR=$( cd ${0%/*}/.. >& /dev/null ; pwd -P )
+FIXTURE="${BASEDIR}/test/sp4"
+SP4="${BASEDIR}/sp4"
+SFC="${BASEDIR}/sfc"
+RESULTS="results results.unknown results.splitPairs"
+
+# lines that differ from run to run, or with the input file
+VOLATILE='VmRSS|Total time to process|String table memory|file with read data'
+
+for prog in "$SP4" "$SFC"; do
+    if [ ! -x "$prog" ]; then echo "$prog not built, run make test" >&2; exit 1; fi
+done
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cp "$FIXTURE"/data.split1stcolumn "$FIXTURE"/data.bowtie.txt "$FIXTURE"/refFlat.txt "$FIXTURE"/bound.txt "$WORK"
+cd "$WORK"
+
+# inputs in the other formats sp4 reads
+gzip -c data.split1stcolumn > data.split1stcolumn.gz
+"$SFC" data.bowtie.txt > /dev/null
+"$SFC" -b data.bowtie.txt > /dev/null
+
+failed=0
+
+# part_starts, how sp4 splits the read data between threads, checked on
+# sizes too large to make a data file for
+if ! g++ -O2 -std=c++11 -o part_starts_test "$BASEDIR/test/part_starts_test.cpp" || ! ./part_starts_test; then
+    echo "FAIL part_starts"
+    failed=1
+fi
+
+# run_sp4 name dataFile [sp4 options...]
+function run_sp4() {
+    name=$1
+    data=$2
+    shift 2
+    mkdir -p "$name"
+    # options file, see readOptionsFromFile in splitPairs.cpp
+    printf '%s\n40000\n30\nrefFlat.txt\nbound.txt\n2\n5\n%s\n2\n' "$data" "$name/base" > "$name/options.txt"
+    if ! "$SP4" "$name/options.txt" "$@" > "$name/stdout.txt" 2>&1; then
+        echo "FAIL $name: sp4 exited with an error, see below"
+        cat "$name/stdout.txt"
+        failed=1
+        return
+    fi
+    # the results are named the same in every run, so they can be compared
+    for r in $RESULTS; do
+        grep -v -E "$VOLATILE" "$name/base.$r" | sed "s#$name/base#base#" > "$name/$r"
+    done
+
+    if [ "$UPDATE" == "1" ]; then
+        for r in $RESULTS; do cp "$name/$r" "$FIXTURE/expected/base.$r"; done
+        echo "updated expected output from $name"
+        UPDATE=0
+        return
+    fi
+
+    for r in $RESULTS; do
+        if ! diff -u "$FIXTURE/expected/base.$r" "$name/$r" > "$name/$r.diff"; then
+            echo "FAIL $name: base.$r differs from expected"
+            head -40 "$name/$r.diff"
+            failed=1
+            return
+        fi
+    done
+    echo "ok   $name"
+}
+
+UPDATE=0
+if [ "$1" == "--update" ]; then UPDATE=1; fi
+
+run_sp4 text        data.split1stcolumn
+run_sp4 threads     data.split1stcolumn --threads 3
+run_sp4 memory      data.split1stcolumn --memory 1 --temp-dir .
+run_sp4 gzip        data.split1stcolumn.gz
+run_sp4 sfc         data.bowtie.txt.split1stcolumn
+run_sp4 binary      data.bowtie.txt.split1stcolumn.bin
+run_sp4 binary_mem  data.bowtie.txt.split1stcolumn.bin --memory 1 --temp-dir . --threads 2
+run_sp4 bowtie      data.bowtie.txt
+
+if (( failed )); then
+    echo "sp4 regression test FAILED"
+    exit 1
+fi
+echo "sp4 regression test passed"